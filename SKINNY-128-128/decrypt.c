@@ -37,6 +37,23 @@
 #include "cipher.h"
 #include "constants.h"
 
+/*
+ * Rounds per iteration of the round loop. The round body is repeated
+ * by the assembler (.rept), so this trades code size for loop overhead.
+ * If it equals the number of rounds, the AVR code has no round counter
+ * and no branch back.
+ */
+#ifndef UNROLL_FACTOR
+#define UNROLL_FACTOR 1
+#endif
+
+#if (40 % UNROLL_FACTOR) != 0
+#error "UNROLL_FACTOR must divide the number of rounds"
+#endif
+
+#define STR_(x) #x
+#define STR(x)  STR_(x)
+
 #ifdef AVR
 void Decrypt(uint8_t *block, uint8_t *roundKeys)
 {
@@ -102,19 +119,109 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         "ld          r21,          x+        \n\t"
         "ld          r22,          x+        \n\t"
         "ld          r23,          x         \n\t"
-        // point to the round keys of last round
-        "ldi         r24,          255       \n\t"
-        "clr         r25                     \n\t"
-        "add         r30,          r24       \n\t"
-        "adc         r31,          r25       \n\t"
-        "adiw        r30,          57        \n\t"
-        // set currentRound
-        "ldi         r24,          40        \n\t"
+        // point to the end of the round keys of last round, they are
+        // read backwards with pre-decrement so no rewind is needed
+        "subi        r30,          lo8(-320) \n\t"
+        "sbci        r31,          hi8(-320) \n\t"
         // used for const 0x02
         "ldi         r25,          0x02      \n\t"
         "ldi         r29,          hi8(INV_SBOX)\n\t"
+        #if defined(SPEED_MODE)
+        // Fully unrolled. Inverse SubCells is done in place and the
+        // row order of Inverse MixColumns and Inverse ShiftRows is
+        // tracked by renaming the registers passed to dec_round.
+        // The order repeats every 8 rounds.
+        ".macro      dec_round s0, s1, s2, s3, s4, s5, s6, s7, s8, s9, s10, s11, s12, s13, s14, s15 \n\t"
+        // Inverse MixColumns
+        // first column
+        "eor         \\s0,        \\s12     \n\t"
+        "eor         \\s12,       \\s4      \n\t"
+        "eor         \\s8,        \\s12     \n\t"
+        // second column
+        "eor         \\s1,        \\s13     \n\t"
+        "eor         \\s13,       \\s5      \n\t"
+        "eor         \\s9,        \\s13     \n\t"
+        // third column
+        "eor         \\s2,        \\s14     \n\t"
+        "eor         \\s14,       \\s6      \n\t"
+        "eor         \\s10,       \\s14     \n\t"
+        // fourth column
+        "eor         \\s3,        \\s15     \n\t"
+        "eor         \\s15,       \\s7      \n\t"
+        "eor         \\s11,       \\s15     \n\t"
+        // Inverse ShiftRows, Inverse AddRoundTweakey, Inverse AddConstants
+        // the rows are now s4 s5 s6 s7 / s9 s10 s11 s8 / s14 s15 s12 s13 /
+        // s3 s0 s1 s2, the round keys are read backwards
+        "ld          r6,          -z        \n\t"
+        "eor         \\s8,        r6        \n\t"
+        "ld          r6,          -z        \n\t"
+        "eor         \\s11,       r6        \n\t"
+        "ld          r6,          -z        \n\t"
+        "eor         \\s10,       r6        \n\t"
+        "ld          r6,          -z        \n\t"
+        "eor         \\s9,        r6        \n\t"
+        "ld          r6,          -z        \n\t"
+        "eor         \\s7,        r6        \n\t"
+        "ld          r6,          -z        \n\t"
+        "eor         \\s6,        r6        \n\t"
+        "ld          r6,          -z        \n\t"
+        "eor         \\s5,        r6        \n\t"
+        "ld          r6,          -z        \n\t"
+        "eor         \\s4,        r6        \n\t"
+        "eor         \\s14,       r25       \n\t"
+        // Inverse SubCells, in place
+        "mov         r28,         \\s0      \n\t"
+        "ld          \\s0,        y         \n\t"
+        "mov         r28,         \\s1      \n\t"
+        "ld          \\s1,        y         \n\t"
+        "mov         r28,         \\s2      \n\t"
+        "ld          \\s2,        y         \n\t"
+        "mov         r28,         \\s3      \n\t"
+        "ld          \\s3,        y         \n\t"
+        "mov         r28,         \\s4      \n\t"
+        "ld          \\s4,        y         \n\t"
+        "mov         r28,         \\s5      \n\t"
+        "ld          \\s5,        y         \n\t"
+        "mov         r28,         \\s6      \n\t"
+        "ld          \\s6,        y         \n\t"
+        "mov         r28,         \\s7      \n\t"
+        "ld          \\s7,        y         \n\t"
+        "mov         r28,         \\s8      \n\t"
+        "ld          \\s8,        y         \n\t"
+        "mov         r28,         \\s9      \n\t"
+        "ld          \\s9,        y         \n\t"
+        "mov         r28,         \\s10     \n\t"
+        "ld          \\s10,       y         \n\t"
+        "mov         r28,         \\s11     \n\t"
+        "ld          \\s11,       y         \n\t"
+        "mov         r28,         \\s12     \n\t"
+        "ld          \\s12,       y         \n\t"
+        "mov         r28,         \\s13     \n\t"
+        "ld          \\s13,       y         \n\t"
+        "mov         r28,         \\s14     \n\t"
+        "ld          \\s14,       y         \n\t"
+        "mov         r28,         \\s15     \n\t"
+        "ld          \\s15,       y         \n\t"
+        ".endm       \n\t"
+        ".rept       5                      \n\t"
+        "dec_round   r8, r9, r10, r11, r12, r13, r14, r15, r16, r17, r18, r19, r20, r21, r22, r23 \n\t"
+        "dec_round   r12, r13, r14, r15, r17, r18, r19, r16, r22, r23, r20, r21, r11, r8, r9, r10 \n\t"
+        "dec_round   r17, r18, r19, r16, r23, r20, r21, r22, r9, r10, r11, r8, r15, r12, r13, r14 \n\t"
+        "dec_round   r23, r20, r21, r22, r10, r11, r8, r9, r13, r14, r15, r12, r16, r17, r18, r19 \n\t"
+        "dec_round   r10, r11, r8, r9, r14, r15, r12, r13, r18, r19, r16, r17, r22, r23, r20, r21 \n\t"
+        "dec_round   r14, r15, r12, r13, r19, r16, r17, r18, r20, r21, r22, r23, r9, r10, r11, r8 \n\t"
+        "dec_round   r19, r16, r17, r18, r21, r22, r23, r20, r11, r8, r9, r10, r13, r14, r15, r12 \n\t"
+        "dec_round   r21, r22, r23, r20, r8, r9, r10, r11, r15, r12, r13, r14, r18, r19, r16, r17 \n\t"
+        ".endr       \n\t"
+        ".purgem     dec_round              \n\t"
+        #else
+        #if UNROLL_FACTOR < 40
+        // set currentRound
+        "ldi         r24,          40/" STR(UNROLL_FACTOR) "        \n\t"
+        #endif
         // encryption
     "dec_loop:                               \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // Inverse MixColumns
         // eor s0, s12
         // eor s12, s4
@@ -144,23 +251,22 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         //                s8  s9  s10 s11  =   r16 r17 r18 r19
         // Cipher State   s12 s13 s14 s15  =   r20 r21 r22 r23
         //                s0  s1  s2  s3       r8  r9  r10 r11
-        "ld          r6,          z+         \n\t"
-        "eor         r12,         r6         \n\t"
-        "ld          r6,          z+         \n\t"
-        "eor         r13,         r6         \n\t"
-        "ld          r6,          z+         \n\t"
-        "eor         r14,         r6         \n\t"
-        "ld          r6,          z+         \n\t"
-        "eor         r15,         r6         \n\t"
-        "ld          r6,          z+         \n\t"
-        "eor         r17,         r6         \n\t"
-        "ld          r6,          z+         \n\t"
-        "eor         r18,         r6         \n\t"
-        "ld          r6,          z+         \n\t"
-        "eor         r19,         r6         \n\t"
-        "ld          r6,          z+         \n\t"
+        "ld          r6,          -z         \n\t"
         "eor         r16,         r6         \n\t"
-        "sbiw        r30,         16         \n\t"
+        "ld          r6,          -z         \n\t"
+        "eor         r19,         r6         \n\t"
+        "ld          r6,          -z         \n\t"
+        "eor         r18,         r6         \n\t"
+        "ld          r6,          -z         \n\t"
+        "eor         r17,         r6         \n\t"
+        "ld          r6,          -z         \n\t"
+        "eor         r15,         r6         \n\t"
+        "ld          r6,          -z         \n\t"
+        "eor         r14,         r6         \n\t"
+        "ld          r6,          -z         \n\t"
+        "eor         r13,         r6         \n\t"
+        "ld          r6,          -z         \n\t"
+        "eor         r12,         r6         \n\t"
         "eor         r22,         r25        \n\t"
         // Inverse SubCells
         // The INV_SBOX is stored in RAM. It can also be stored in Flash.
@@ -206,10 +312,18 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         "ld          r16,         y          \n\t"
         "mov         r28,         r7         \n\t"
         "ld          r22,         y          \n\t"
-        "dec         r24                     \n\t"
+        ".endr                  \n\t"
+    #if UNROLL_FACTOR < 40
+    "dec             r24                     \n\t"
+    #if UNROLL_FACTOR > 1
     "breq            dec_exit                \n\t"
     "rjmp            dec_loop                \n\t"
     "dec_exit:                               \n\t"
+    #else
+    "brne            dec_loop                \n\t"
+    #endif
+    #endif
+        #endif
         //                s0  s1  s2  s3       r8  r9  r10 r11
         //                s4  s5  s6  s7   =   r12 r13 r14 r15
         // Cipher State   s8  s9  s10 s11  =   r16 r17 r18 r19
@@ -257,8 +371,11 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
     /* r12     : temp use                    */
     /* r13     : currentRound                */
     /* r14     : point to round keys         */
-    /* r15     : point to block              */
+    /* r15     : point to block, then spare  */
     asm volatile(
+        #if defined(__MSP430X__)
+        "pushm       #8,        r11        \n\t"
+        #else
         "push        r4         \n\t"
         "push        r5         \n\t"
         "push        r6         \n\t"
@@ -267,83 +384,132 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         "push        r9         \n\t"
         "push        r10        \n\t"
         "push        r11        \n\t"
+        #endif
         // load ciphertext
-        "mov         #40,           r13     \n\t"
-        "add         #312,          r14     \n\t"
+        "mov         #40/" STR(UNROLL_FACTOR) ",           r13     \n\t"
+        "add         #312,      r14          \n\t"
+        "mov         0(r15),    r4           \n\t"
+        "mov         2(r15),    r5           \n\t"
+        "mov         4(r15),    r6           \n\t"
+        "mov         6(r15),    r7           \n\t"
+        "mov         8(r15),    r8           \n\t"
+        "mov         10(r15),   r9           \n\t"
+        "mov         12(r15),   r10          \n\t"
+        "mov         14(r15),   r11          \n\t"
+        "push        r15                     \n\t"
     "dec_loop:                              \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // Inverse MixColumns
-        // s0  s1  s2  s3  |xor s12, s0 |  s4  s5  s6  s7
-        // s4  s5  s6  s7  |xor s4,  s12|  s8  s9  s10 s11
-        // s8  s9  s10 s11 |xor s12, s8 |  s12 s13 s14 s15
-        // s12 s13 s14 s15 ------------->  s0  s1  s2  s3
-        "mov         0(r15),        r4      \n\t"
-        "mov         2(r15),        r5      \n\t"
-        "mov         4(r15),        r6      \n\t"
-        "mov         6(r15),        r7      \n\t"
-        "mov         8(r15),        r8      \n\t"
-        "mov         10(r15),       r9      \n\t"
-        "mov         12(r15),       r10     \n\t"
-        "mov         14(r15),       r11     \n\t"
-        "xor         r10,           r4      \n\t"
-        "xor         r6,            r10     \n\t"
-        "xor         r10,           r8      \n\t"
-        "xor         r11,           r5      \n\t"
-        "xor         r7,            r11     \n\t"
-        "xor         r11,           r9      \n\t"
-        "mov         r6,            0(r15)  \n\t"
-        "mov         r7,            2(r15)  \n\t"
-        "mov         r8,            4(r15)  \n\t"
-        "mov         r9,            6(r15)  \n\t"
-        "mov         r10,           8(r15)  \n\t"
-        "mov         r11,           10(r15) \n\t"
-        "mov         r4,            12(r15) \n\t"
-        "mov         r5,            14(r15) \n\t"
-        // Inverse ShiftRows, Inverse AddConstants, Inverse AddRoundTweakey
-        // and Inverse SubCells
-        "mov.b       0(r15),        r4      \n\t" // s0' = INV_SBOX[s0]^rks[0]^rc
-        "xor.b       @r14+,         r4      \n\t"
-        "mov.b       INV_SBOX(r4),  0(r15)  \n\t" 
-        "mov.b       1(r15),        r4      \n\t" // s1' = INV_SBOX[s1]^rks[1]
-        "xor.b       @r14+,         r4      \n\t"
-        "mov.b       INV_SBOX(r4),  1(r15)  \n\t"
-        "mov.b       2(r15),        r4      \n\t" // s2' = INV_SBOX[s2]^rks[2]
-        "xor.b       @r14+,         r4      \n\t"
-        "mov.b       INV_SBOX(r4),  2(r15)  \n\t"
-        "mov.b       3(r15),        r4      \n\t" // s3' = INV_SBOX[s3]^rks[3]
-        "xor.b       @r14+,         r4      \n\t"
-        "mov.b       INV_SBOX(r4),  3(r15)  \n\t"
-        "mov.b       4(r15),        r12     \n\t"
-        "mov.b       5(r15),        r4      \n\t" // s4' = INV_SBOX[s4]^rks[4]^rc
-        "xor.b       @r14+,         r4      \n\t"
-        "mov.b       INV_SBOX(r4),  4(r15)  \n\t"
-        "mov.b       6(r15),        r4      \n\t" // s5' = INV_SBOX[s5]^rks[5]
-        "xor.b       @r14+,         r4      \n\t"
-        "mov.b       INV_SBOX(r4),  5(r15)  \n\t"
-        "mov.b       7(r15),        r4      \n\t" // s6' = INV_SBOX[s6]^rks[6]
-        "xor.b       @r14+,         r4      \n\t"
-        "mov.b       INV_SBOX(r4),  6(r15)  \n\t"
-        "xor.b       @r14+,         r12     \n\t" // s7' = INV_SBOX[s7]^rks[7]
-        "mov.b       INV_SBOX(r12), 7(r15)  \n\t"
-        "sub         #16,           r14     \n\t"
-        "mov.b       8(r15),        r12     \n\t"
-        "mov.b       10(r15),       r4      \n\t" // s8' = INV_SBOX[s8]^rc
-        "xor.b       #0x0002,       r4      \n\t"
-        "mov.b       INV_SBOX(r4),  8(r15)  \n\t"
-        "mov.b       INV_SBOX(r12), 10(r15) \n\t" // s10' = INV_SBOX[s10]
-        "mov.b       9(r15),        r12     \n\t"
-        "mov.b       11(r15),       r4      \n\t" // s9' = INV_SBOX[s9]
-        "mov.b       INV_SBOX(r4),  9(r15)  \n\t"
-        "mov.b       INV_SBOX(r12), 11(r15) \n\t" // s11' = INV_SBOX[s11]
-        "mov.b       15(r15),       r12     \n\t"
-        "mov.b       14(r15),       r4      \n\t" // s12' = INV_SBOX[s12]
-        "mov.b       INV_SBOX(r4),  15(r15) \n\t"
-        "mov.b       13(r15),       r4      \n\t" // s13' = INV_SBOX[s13]
-        "mov.b       INV_SBOX(r4),  14(r15) \n\t"
-        "mov.b       12(r15),       r4      \n\t" // s14' = INV_SBOX[s14]
-        "mov.b       INV_SBOX(r4),  13(r15) \n\t"
-        "mov.b       INV_SBOX(r12), 12(r15) \n\t" // s15' = INV_SBOX[s15]
+        // the rows are left in (r6, r7), (r8, r9), (r10, r11), (r4, r5)
+        "xor         r10,       r4           \n\t"
+        "xor         r11,       r5           \n\t"
+        "xor         r6,        r10          \n\t"
+        "xor         r7,        r11          \n\t"
+        "xor         r10,       r8           \n\t"
+        "xor         r11,       r9           \n\t"
+        // Inverse ShiftRows: swpb and an exchange of the high (row 1)
+        // or low (row 3) bytes. Row 2 becomes (r11, r10).
+        "swpb        r8                      \n\t"
+        "swpb        r9                      \n\t"
+        "mov         r8,        r12          \n\t"
+        "xor         r9,        r12          \n\t"
+        "and         #0xff00,   r12          \n\t"
+        "xor         r12,       r8           \n\t"
+        "xor         r12,       r9           \n\t"
+        "swpb        r4                      \n\t"
+        "swpb        r5                      \n\t"
+        "mov         r4,        r12          \n\t"
+        "xor         r5,        r12          \n\t"
+        "and         #0x00ff,   r12          \n\t"
+        "xor         r12,       r4           \n\t"
+        "xor         r12,       r5           \n\t"
+        // Inverse AddConstants and Inverse AddRoundTweakey
+        "xor         @r14+,     r6           \n\t"
+        "xor         @r14+,     r7           \n\t"
+        "xor         @r14+,     r8           \n\t"
+        "xor         @r14+,     r9           \n\t"
+        "sub         #16,       r14          \n\t"
+        "xor         #2,        r11          \n\t"
+        // Inverse SubCells. Each word is written back in the order
+        // s0 ... s15 = r4 ... r11. r15 is the spare register.
+        "mov.b       r4,        r12          \n\t"
+        "mov.b       INV_SBOX(r12), r12      \n\t"
+        "swpb        r4                      \n\t"
+        "mov.b       r4,        r4           \n\t"
+        "mov.b       INV_SBOX(r4), r15       \n\t"
+        "swpb        r15                     \n\t"
+        "bis         r12,       r15          \n\t"
+        "mov.b       r6,        r12          \n\t"
+        "mov.b       INV_SBOX(r12), r12      \n\t"
+        "swpb        r6                      \n\t"
+        "mov.b       r6,        r6           \n\t"
+        "mov.b       INV_SBOX(r6), r4        \n\t"
+        "swpb        r4                      \n\t"
+        "bis         r12,       r4           \n\t"
+        "mov.b       r8,        r12          \n\t"
+        "mov.b       INV_SBOX(r12), r12      \n\t"
+        "swpb        r8                      \n\t"
+        "mov.b       r8,        r8           \n\t"
+        "mov.b       INV_SBOX(r8), r6        \n\t"
+        "swpb        r6                      \n\t"
+        "bis         r12,       r6           \n\t"
+        "mov.b       r11,       r12          \n\t"
+        "mov.b       INV_SBOX(r12), r12      \n\t"
+        "swpb        r11                     \n\t"
+        "mov.b       r11,       r11          \n\t"
+        "mov.b       INV_SBOX(r11), r8       \n\t"
+        "swpb        r8                      \n\t"
+        "bis         r12,       r8           \n\t"
+        "mov.b       r5,        r12          \n\t"
+        "mov.b       INV_SBOX(r12), r12      \n\t"
+        "swpb        r5                      \n\t"
+        "mov.b       r5,        r5           \n\t"
+        "mov.b       INV_SBOX(r5), r11       \n\t"
+        "swpb        r11                     \n\t"
+        "bis         r12,       r11          \n\t"
+        "mov.b       r7,        r12          \n\t"
+        "mov.b       INV_SBOX(r12), r12      \n\t"
+        "swpb        r7                      \n\t"
+        "mov.b       r7,        r7           \n\t"
+        "mov.b       INV_SBOX(r7), r5        \n\t"
+        "swpb        r5                      \n\t"
+        "bis         r12,       r5           \n\t"
+        "mov.b       r9,        r12          \n\t"
+        "mov.b       INV_SBOX(r12), r12      \n\t"
+        "swpb        r9                      \n\t"
+        "mov.b       r9,        r9           \n\t"
+        "mov.b       INV_SBOX(r9), r7        \n\t"
+        "swpb        r7                      \n\t"
+        "bis         r12,       r7           \n\t"
+        "mov.b       r10,       r12          \n\t"
+        "mov.b       INV_SBOX(r12), r12      \n\t"
+        "swpb        r10                     \n\t"
+        "mov.b       r10,       r10          \n\t"
+        "mov.b       INV_SBOX(r10), r9       \n\t"
+        "swpb        r9                      \n\t"
+        "bis         r12,       r9           \n\t"
+        "mov         r15,       r10          \n\t"
+        ".endr                  \n\t"
     "dec             r13                    \n\t"
+    #if UNROLL_FACTOR > 1
+    "jeq             dec_exit               \n\t"
+    "br              #dec_loop              \n\t"
+    "dec_exit:                              \n\t"
+    #else
     "jne             dec_loop               \n\t"
+    #endif
+        "pop         r15                     \n\t"
+        "mov         r4,        0(r15)       \n\t"
+        "mov         r5,        2(r15)       \n\t"
+        "mov         r6,        4(r15)       \n\t"
+        "mov         r7,        6(r15)       \n\t"
+        "mov         r8,        8(r15)       \n\t"
+        "mov         r9,        10(r15)      \n\t"
+        "mov         r10,       12(r15)      \n\t"
+        "mov         r11,       14(r15)      \n\t"
+        #if defined(__MSP430X__)
+        "popm        #8,        r11        \n\t"
+        #else
         "pop         r11        \n\t"
         "pop         r10        \n\t"
         "pop         r9         \n\t"
@@ -352,6 +518,7 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         "pop         r6         \n\t"
         "pop         r5         \n\t"
         "pop         r4         \n\t"
+        #endif
     :
     : [block] "m" (block), [roundKeys] "m" (roundKeys), [INV_SBOX] "" (INV_SBOX));
 }
@@ -368,12 +535,14 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys) {
     // r10   : 0xff
     asm volatile(
         "stmdb      sp!,      {r2-r10}         \n\t"
-        "mov        r8,       #40              \n\t"
-        "ldr        r9,       =INV_SBOX        \n\t"
+        "mov        r8,       #40/" STR(UNROLL_FACTOR) "              \n\t"
+        "movw       r9,       #:lower16:INV_SBOX       \n\t"
+        "movt       r9,       #:upper16:INV_SBOX       \n\t"
         "mov        r10,      #0xff            \n\t"
         "ldmia      r0,       {r2-r5}          \n\t" // load ciphertext
         "adds       r1,       r1, #312         \n\t" // points to last round
     "enc_loop:                                 \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // Inverse MixColumns
         // eor  s0,  s12
         // eor  s12, s4
@@ -453,6 +622,7 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys) {
         "mov        r6,       r5, lsr #24      \n\t"
         "ldrb       r6,       [r9,r6]          \n\t"
         "bfi        r5,r6,    #24, #8          \n\t"
+        ".endr                  \n\t"
     "subs           r8,       r8, #1           \n\t"
     "bne            enc_loop                   \n\t"
         "stmia      r0,       {r2-r5}          \n\t" // store plaintext
@@ -462,9 +632,188 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys) {
 }
 
 #else
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+/*
+ * Same layout as Encrypt: row i in the 32-bit lane i. INV_SBOX is the
+ * inverse NOR/XOR circuit applied to the 16 bytes at once.
+ */
+static inline __m128i sbox_mix(__m128i x)
+{
+    __m128i t = _mm_or_si128(_mm_srli_epi32(x, 1), x);
+
+    t = _mm_andnot_si128(_mm_srli_epi32(t, 2), _mm_set1_epi32(0x11111111));
+    return _mm_xor_si128(x, t);
+}
+
+static inline __m128i sbox_permute_inv(__m128i x)
+{
+    __m128i y;
+
+    y = _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x08080808)), 1);
+    y = _mm_or_si128(y, _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x32323232)), 2));
+    y = _mm_or_si128(y, _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x01010101)), 5));
+    y = _mm_or_si128(y, _mm_srli_epi32(_mm_and_si128(x, _mm_set1_epi32(0xc0c0c0c0)), 5));
+    y = _mm_or_si128(y, _mm_srli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x04040404)), 2));
+    return y;
+}
+
+static inline __m128i InvSubCells(__m128i x)
+{
+    __m128i y;
+
+    // swap bit 1 and bit 2
+    y = _mm_and_si128(x, _mm_set1_epi32(0xf9f9f9f9));
+    y = _mm_or_si128(y, _mm_and_si128(_mm_srli_epi32(x, 1), _mm_set1_epi32(0x02020202)));
+    x = _mm_or_si128(y, _mm_and_si128(_mm_slli_epi32(x, 1), _mm_set1_epi32(0x04040404)));
+    x = sbox_mix(x);
+    x = sbox_permute_inv(x);
+    x = sbox_mix(x);
+    x = sbox_permute_inv(x);
+    x = sbox_mix(x);
+    x = sbox_permute_inv(x);
+    return sbox_mix(x);
+}
+
+static inline __m128i InvShiftRows(__m128i x)
+{
+#if defined(__SSSE3__)
+    return _mm_shuffle_epi8(x, _mm_setr_epi8(0, 1, 2, 3, 5, 6, 7, 4,
+                                             10, 11, 8, 9, 15, 12, 13, 14));
+#else
+    // row i is rotated right by 8*i bits
+    __m128i r1 = _mm_or_si128(_mm_srli_epi32(x, 8), _mm_slli_epi32(x, 24));
+    __m128i r2 = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128i r3 = _mm_or_si128(_mm_srli_epi32(x, 24), _mm_slli_epi32(x, 8));
+
+    x = _mm_and_si128(x, _mm_setr_epi32(-1, 0, 0, 0));
+    x = _mm_or_si128(x, _mm_and_si128(r1, _mm_setr_epi32(0, -1, 0, 0)));
+    x = _mm_or_si128(x, _mm_and_si128(r2, _mm_setr_epi32(0, 0, -1, 0)));
+    x = _mm_or_si128(x, _mm_and_si128(r3, _mm_setr_epi32(0, 0, 0, -1)));
+    return x;
+#endif
+}
+
+static inline __m128i InvMixColumns(__m128i x)
+{
+    // (r1, r1 ^ r2 ^ r3, r1 ^ r3, r0 ^ r3)
+    __m128i a = _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 1, 1, 1));
+    __m128i b = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 2, 0));
+    __m128i c = _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 0, 3, 0));
+
+    b = _mm_and_si128(b, _mm_setr_epi32(0, -1, -1, -1));
+    c = _mm_and_si128(c, _mm_setr_epi32(0, -1, 0, 0));
+    return _mm_xor_si128(_mm_xor_si128(a, b), c);
+}
+
+void Decrypt(uint8_t *block, uint8_t *roundKeys)
+{
+    const __m128i c2 = _mm_setr_epi32(0, 0, 0x02, 0);
+    __m128i s = _mm_loadu_si128((__m128i *)block);
+    uint8_t i;
+
+    for (i = 40; i > 0; i--)
+    {
+        s = InvMixColumns(s);
+        s = InvShiftRows(s);
+        s = _mm_xor_si128(s, _mm_loadl_epi64((__m128i *)(roundKeys + 8 * (i - 1))));
+        s = _mm_xor_si128(s, c2);
+        s = InvSubCells(s);
+    }
+    _mm_storeu_si128((__m128i *)block, s);
+}
+
+#else
+/*
+ * Portable version for hosts without SIMD: rows 0-1 in s[0] and rows
+ * 2-3 in s[1], row i in a 32-bit half with its first cell in the low
+ * byte.
+ */
+static inline uint64_t sbox_mix(uint64_t x)
+{
+    return x ^ (~((x >> 3) | (x >> 2)) & 0x1111111111111111ULL);
+}
+
+static inline uint64_t sbox_permute_inv(uint64_t x)
+{
+    return ((x & 0x0808080808080808ULL) << 1) |
+           ((x & 0x3232323232323232ULL) << 2) |
+           ((x & 0x0101010101010101ULL) << 5) |
+           ((x & 0xc0c0c0c0c0c0c0c0ULL) >> 5) |
+           ((x & 0x0404040404040404ULL) >> 2);
+}
+
+static inline uint64_t InvSubCells(uint64_t x)
+{
+    // swap bit 1 and bit 2
+    x = (x & 0xf9f9f9f9f9f9f9f9ULL) |
+        ((x >> 1) & 0x0202020202020202ULL) |
+        ((x << 1) & 0x0404040404040404ULL);
+    x = sbox_mix(x);
+    x = sbox_permute_inv(x);
+    x = sbox_mix(x);
+    x = sbox_permute_inv(x);
+    x = sbox_mix(x);
+    x = sbox_permute_inv(x);
+    return sbox_mix(x);
+}
+
+static inline void InvShiftRows(uint64_t *s)
+{
+    // row i is rotated right by 8*i bits
+    s[0] = (s[0] & 0x00000000ffffffffULL) |
+           ((s[0] >> 8) & 0x00ffffff00000000ULL) |
+           ((s[0] << 24) & 0xff00000000000000ULL);
+    s[1] = ((s[1] << 16) & 0x00000000ffff0000ULL) |
+           ((s[1] >> 16) & 0x000000000000ffffULL) |
+           ((s[1] << 8) & 0xffffff0000000000ULL) |
+           ((s[1] >> 24) & 0x000000ff00000000ULL);
+}
+
+static inline void InvMixColumns(uint64_t *s)
+{
+    uint32_t r0 = s[0], r1 = s[0] >> 32, r2 = s[1], r3 = s[1] >> 32;
+
+    r3 ^= r1;
+    r2 ^= r3;
+    r0 ^= r3 ^ r1;
+    s[0] = ((uint64_t)r2 << 32) | r1;
+    s[1] = ((uint64_t)r0 << 32) | r3;
+}
+
 void Decrypt(uint8_t *block, uint8_t *roundKeys)
 {
-    /* Add here the cipher decryption implementation */
+    uint64_t s[2], k;
+    uint8_t i, j;
+
+    s[0] = s[1] = 0;
+    for (j = 8; j > 0; j--)
+    {
+        s[0] = (s[0] << 8) | block[j - 1];
+        s[1] = (s[1] << 8) | block[j + 7];
+    }
+    for (i = 40; i > 0; i--)
+    {
+        InvMixColumns(s);
+        InvShiftRows(s);
+        k = 0;
+        for (j = 8; j > 0; j--)
+        {
+            k = (k << 8) | roundKeys[8 * (i - 1) + j - 1];
+        }
+        s[0] = InvSubCells(s[0] ^ k);
+        s[1] = InvSubCells(s[1] ^ 0x02);
+    }
+    for (j = 0; j < 8; j++)
+    {
+        block[j] = s[0] >> (8 * j);
+        block[j + 8] = s[1] >> (8 * j);
+    }
 }
 
 #endif
+#endif
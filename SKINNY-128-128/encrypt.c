@@ -37,6 +37,23 @@
 #include "cipher.h"
 #include "constants.h"
 
+/*
+ * Rounds per iteration of the round loop. The round body is repeated
+ * by the assembler (.rept), so this trades code size for loop overhead.
+ * If it equals the number of rounds, the AVR code has no round counter
+ * and no branch back.
+ */
+#ifndef UNROLL_FACTOR
+#define UNROLL_FACTOR 1
+#endif
+
+#if (40 % UNROLL_FACTOR) != 0
+#error "UNROLL_FACTOR must divide the number of rounds"
+#endif
+
+#define STR_(x) #x
+#define STR(x)  STR_(x)
+
 #ifdef AVR
 void Encrypt(uint8_t *block, uint8_t *roundKeys)
 {
@@ -104,13 +121,122 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "ld          r19,         x+        \n\t"
         "ld          r16,         x+        \n\t"
         "ld          r17,         x         \n\t"
-        // set currentRound
-        "ldi         r24,         40        \n\t"
         // used for constant 0x02
         "ldi         r25,         0x02      \n\t"
         "ldi         r29,         hi8(SBOX) \n\t"
+        #if defined(SPEED_MODE)
+        // Fully unrolled. SubCells is done in place and ShiftRows,
+        // together with the row order left by MixColumns, is done by
+        // renaming: enc_round takes the registers holding s0 ... s15.
+        // The order repeats every 8 rounds, so no movw is needed.
+        ".macro      enc_round s0, s1, s2, s3, s4, s5, s6, s7, s8, s9, s10, s11, s12, s13, s14, s15 \n\t"
+        // SubCells, in place
+        "mov         r28,         \\s0      \n\t"
+        "ld          \\s0,        y         \n\t"
+        "mov         r28,         \\s1      \n\t"
+        "ld          \\s1,        y         \n\t"
+        "mov         r28,         \\s2      \n\t"
+        "ld          \\s2,        y         \n\t"
+        "mov         r28,         \\s3      \n\t"
+        "ld          \\s3,        y         \n\t"
+        "mov         r28,         \\s4      \n\t"
+        "ld          \\s4,        y         \n\t"
+        "mov         r28,         \\s5      \n\t"
+        "ld          \\s5,        y         \n\t"
+        "mov         r28,         \\s6      \n\t"
+        "ld          \\s6,        y         \n\t"
+        "mov         r28,         \\s7      \n\t"
+        "ld          \\s7,        y         \n\t"
+        "mov         r28,         \\s8      \n\t"
+        "ld          \\s8,        y         \n\t"
+        "mov         r28,         \\s9      \n\t"
+        "ld          \\s9,        y         \n\t"
+        "mov         r28,         \\s10     \n\t"
+        "ld          \\s10,       y         \n\t"
+        "mov         r28,         \\s11     \n\t"
+        "ld          \\s11,       y         \n\t"
+        "mov         r28,         \\s12     \n\t"
+        "ld          \\s12,       y         \n\t"
+        "mov         r28,         \\s13     \n\t"
+        "ld          \\s13,       y         \n\t"
+        "mov         r28,         \\s14     \n\t"
+        "ld          \\s14,       y         \n\t"
+        "mov         r28,         \\s15     \n\t"
+        "ld          \\s15,       y         \n\t"
+        // AddConstants and AddRoundTweakey
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "lpm         r6,          z+        \n\t"
+        "eor         \\s0,        r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         \\s1,        r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         \\s2,        r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         \\s3,        r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         \\s4,        r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         \\s5,        r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         \\s6,        r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         \\s7,        r6        \n\t"
+        #else
+        "ld          r6,          z+        \n\t"
+        "eor         \\s0,        r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         \\s1,        r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         \\s2,        r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         \\s3,        r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         \\s4,        r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         \\s5,        r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         \\s6,        r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         \\s7,        r6        \n\t"
+        #endif
+        "eor         \\s8,        r25       \n\t"
+        // ShiftRows and MixColumns
+        // first column: s0 s7 s10 s13
+        "eor         \\s7,        \\s10     \n\t"
+        "eor         \\s10,       \\s0      \n\t"
+        "eor         \\s13,       \\s10     \n\t"
+        // second column: s1 s4 s11 s14
+        "eor         \\s4,        \\s11     \n\t"
+        "eor         \\s11,       \\s1      \n\t"
+        "eor         \\s14,       \\s11     \n\t"
+        // third column: s2 s5 s8 s15
+        "eor         \\s5,        \\s8      \n\t"
+        "eor         \\s8,        \\s2      \n\t"
+        "eor         \\s15,       \\s8      \n\t"
+        // fourth column: s3 s6 s9 s12
+        "eor         \\s6,        \\s9      \n\t"
+        "eor         \\s9,        \\s3      \n\t"
+        "eor         \\s12,       \\s9      \n\t"
+        ".endm       \n\t"
+        ".rept       5                      \n\t"
+        "enc_round   r21, r22, r23, r20, r8, r9, r10, r11, r15, r12, r13, r14, r18, r19, r16, r17 \n\t"
+        "enc_round   r19, r16, r17, r18, r21, r22, r23, r20, r11, r8, r9, r10, r13, r14, r15, r12 \n\t"
+        "enc_round   r14, r15, r12, r13, r19, r16, r17, r18, r20, r21, r22, r23, r9, r10, r11, r8 \n\t"
+        "enc_round   r10, r11, r8, r9, r14, r15, r12, r13, r18, r19, r16, r17, r22, r23, r20, r21 \n\t"
+        "enc_round   r23, r20, r21, r22, r10, r11, r8, r9, r13, r14, r15, r12, r16, r17, r18, r19 \n\t"
+        "enc_round   r17, r18, r19, r16, r23, r20, r21, r22, r9, r10, r11, r8, r15, r12, r13, r14 \n\t"
+        "enc_round   r12, r13, r14, r15, r17, r18, r19, r16, r22, r23, r20, r21, r11, r8, r9, r10 \n\t"
+        "enc_round   r8, r9, r10, r11, r12, r13, r14, r15, r16, r17, r18, r19, r20, r21, r22, r23 \n\t"
+        ".endr       \n\t"
+        ".purgem     enc_round              \n\t"
+        #else
+        #if UNROLL_FACTOR < 40
+        // set currentRound
+        "ldi         r24,         40/" STR(UNROLL_FACTOR) "        \n\t"
+        #endif
         // encryption
     "enc_loop:                              \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // SubCells with ShiftRows
         // The SBOX is stored in RAM. It can also be stored in Flash.
         //               s13 s14 s15 s12      r21 r22 r23 r20
@@ -227,8 +353,18 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "eor         r14,         r17       \n\t"
         "eor         r17,         r11       \n\t"
         "eor         r20,         r17       \n\t"
+        ".endr                  \n\t"
+    #if UNROLL_FACTOR < 40
     "dec             r24                    \n\t"
+    #if UNROLL_FACTOR > 1
+    "breq            enc_exit               \n\t"
+    "rjmp            enc_loop               \n\t"
+    "enc_exit:                              \n\t"
+    #else
     "brne            enc_loop               \n\t"
+    #endif
+    #endif
+        #endif
         // store cipher text
         "st          x,           r17       \n\t"
         "st          -x,          r16       \n\t"
@@ -265,6 +401,229 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
     : [block] "x" (block), [roundKeys] "z" (roundKeys), [SBOX] "" (SBOX));
 }
 
+/*
+ * Runs nRounds rounds (1 to 255) and returns, so that one block can be
+ * encrypted over several calls. ctx holds the 16-byte state followed by
+ * the roundKeys pointer of the next round; both are updated. On MSP
+ * ctx is accessed as words and must be 2-byte aligned.
+ */
+void EncryptStep(uint8_t *ctx, uint8_t nRounds)
+{
+    /*--------------------------------------*/
+    /* r6-r7    : temp use                  */
+    /* r8-r23   : state                     */
+    /* r24      : loop control              */
+    /* r25      : const 0x02                */
+    /* r26-r27  : X points to ctx           */
+    /* r28-r29  : Y points to SBOX          */
+    /* r30-r31  : Z points to roundKeys     */
+    /* -------------------------------------*/
+    // s0  s1  s2  s3       r8  r9  r10 r11
+    // s4  s5  s6  s7   =   r12 r13 r14 r15
+    // s8  s9  s10 s11  =   r16 r17 r18 r19
+    // s12 s13 s14 s15      r20 r21 r22 r23
+    asm volatile(
+        "push        r6         \n\t"
+        "push        r7         \n\t"
+        "push        r8         \n\t"
+        "push        r9         \n\t"
+        "push        r10        \n\t"
+        "push        r11        \n\t"
+        "push        r12        \n\t"
+        "push        r13        \n\t"
+        "push        r14        \n\t"
+        "push        r15        \n\t"
+        "push        r16        \n\t"
+        "push        r17        \n\t"
+        "push        r28        \n\t"
+        "push        r29        \n\t"
+        "mov         r24,         r22       \n\t"
+        // load state and roundKeys pointer
+        // The registers are not in order. This is just to keep
+        // pace with the result of MixColumns.
+        //               s13 s14 s15 s12      r21 r22 r23 r20
+        //               s0  s1  s2  s3   =   r8  r9  r10 r11
+        // Cipher State: s7  s4  s5  s6   =   r15 r12 r13 r14
+        //               s10 s11 s8  s9       r18 r19 r16 r17
+        "ld          r21,         x+        \n\t"
+        "ld          r22,         x+        \n\t"
+        "ld          r23,         x+        \n\t"
+        "ld          r20,         x+        \n\t"
+        "ld          r8,          x+        \n\t"
+        "ld          r9,          x+        \n\t"
+        "ld          r10,         x+        \n\t"
+        "ld          r11,         x+        \n\t"
+        "ld          r15,         x+        \n\t"
+        "ld          r12,         x+        \n\t"
+        "ld          r13,         x+        \n\t"
+        "ld          r14,         x+        \n\t"
+        "ld          r18,         x+        \n\t"
+        "ld          r19,         x+        \n\t"
+        "ld          r16,         x+        \n\t"
+        "ld          r17,         x+        \n\t"
+        "ld          r30,         x+        \n\t"
+        "ld          r31,         x         \n\t"
+        // used for constant 0x02
+        "ldi         r25,         0x02      \n\t"
+        "ldi         r29,         hi8(SBOX) \n\t"
+        // encryption
+    "step_loop:                             \n\t"
+        // SubCells with ShiftRows
+        // The SBOX is stored in RAM. It can also be stored in Flash.
+        //               s13 s14 s15 s12      r21 r22 r23 r20
+        //               s0  s1  s2  s3   =   r8  r9  r10 r11
+        // Cipher State: s7  s4  s5  s6   =   r15 r12 r13 r14
+        //               s10 s11 s8  s9       r18 r19 r16 r17
+        // s0'  = SBOX[s13]  s1'  = SBOX[s14]  s2'  = SBOX[s15]  s3'  = SBOX[s12]
+        // s4'  = SBOX[s0]   s5'  = SBOX[s1]   s6'  = SBOX[s2]   s6'  = SBOX[s3]
+        // s8'  = SBOX[s7]   s9'  = SBOX[s4]   s10' = SBOX[s5]   s11' = SBOX[s6]
+        // s12' = SBOX[s10]  s13' = SBOX[s11]  s14' = SBOX[s8]   s15' = SBOX[s9]
+        "movw        r6,          r8        \n\t"
+        "mov         r28,         r21       \n\t"
+        "ld          r8,          y         \n\t"
+        "mov         r28,         r19       \n\t"
+        "ld          r21,         y         \n\t"
+        "mov         r28,         r14       \n\t"
+        "ld          r19,         y         \n\t"
+        "mov         r28,         r10       \n\t"
+        "ld          r14,         y         \n\t"
+        "mov         r28,         r23       \n\t"
+        "ld          r10,         y         \n\t"
+        "mov         r28,         r17       \n\t"
+        "ld          r23,         y         \n\t"
+        "mov         r28,         r12       \n\t"
+        "ld          r17,         y         \n\t"
+        "mov         r28,         r6        \n\t"
+        "ld          r12,         y         \n\t"
+        // second part
+        "mov         r28,         r22       \n\t"
+        "ld          r9,          y         \n\t"
+        "mov         r28,         r16       \n\t"
+        "ld          r22,         y         \n\t"
+        "mov         r28,         r15       \n\t"
+        "ld          r16,         y         \n\t"
+        "mov         r28,         r11       \n\t"
+        "ld          r15,         y         \n\t"
+        "mov         r28,         r20       \n\t"
+        "ld          r11,         y         \n\t"
+        "mov         r28,         r18       \n\t"
+        "ld          r20,         y         \n\t"
+        "mov         r28,         r13       \n\t"
+        "ld          r18,         y         \n\t"
+        "mov         r28,         r7        \n\t"
+        "ld          r13,         y         \n\t"
+        // AddConstants and AddRoundTweakey
+        // After 'SubCells and ShiftRows', the registers are in
+        // right order.
+        //               s0  s1  s2  s3       r8  r9  r10 r11
+        //               s4  s5  s6  s7   =   r12 r13 r14 r15
+        // Cipher State: s8  s9  s10 s11  =   r16 r17 r18 r19
+        //               s12 s13 s14 s15      r20 r21 r22 r23
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "lpm         r6,          z+        \n\t"
+        "eor         r8,          r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         r9,          r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         r10,         r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         r11,         r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         r12,         r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         r13,         r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         r14,         r6        \n\t"
+        "lpm         r6,          z+        \n\t"
+        "eor         r15,         r6        \n\t"
+        "eor         r16,         r25       \n\t"
+        #else
+        "ld          r6,          z+        \n\t"
+        "eor         r8,          r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         r9,          r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         r10,         r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         r11,         r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         r12,         r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         r13,         r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         r14,         r6        \n\t"
+        "ld          r6,          z+        \n\t"
+        "eor         r15,         r6        \n\t"
+        "eor         r16,         r25       \n\t"
+        #endif
+        // MixColumns
+        // After 'MixColumns', the registers are in wrong order.
+        // And this is recovered to right order in 'SubCells' of
+        // the next round. By doing so, the instructions to
+        // implement 'ShiftRows' can be redecues.
+        // eor  s4,  s8
+        // eor  s8,  s0
+        // eor  s12, s8
+        //               s13 s14 s15 s12      r21 r22 r23 r20
+        //               s0  s1  s2  s3   =   r8  r9  r10 r11
+        // Cipher State: s7  s4  s5  s6   =   r15 r12 r13 r14
+        //               s10 s11 s8  s9       r18 r19 r16 r17
+        // first column
+        "eor         r15,         r18       \n\t"
+        "eor         r18,         r8        \n\t"
+        "eor         r21,         r18       \n\t"
+        // second column
+        "eor         r12,         r19       \n\t"
+        "eor         r19,         r9        \n\t"
+        "eor         r22,         r19       \n\t"
+        // third column
+        "eor         r13,         r16       \n\t"
+        "eor         r16,         r10       \n\t"
+        "eor         r23,         r16       \n\t"
+        // fourth column
+        "eor         r14,         r17       \n\t"
+        "eor         r17,         r11       \n\t"
+        "eor         r20,         r17       \n\t"
+    "dec             r24                    \n\t"
+    "brne            step_loop              \n\t"
+        // store state and roundKeys pointer
+        "st          x,           r31       \n\t"
+        "st          -x,          r30       \n\t"
+        "st          -x,          r17       \n\t"
+        "st          -x,          r16       \n\t"
+        "st          -x,          r19       \n\t"
+        "st          -x,          r18       \n\t"
+        "st          -x,          r14       \n\t"
+        "st          -x,          r13       \n\t"
+        "st          -x,          r12       \n\t"
+        "st          -x,          r15       \n\t"
+        "st          -x,          r11       \n\t"
+        "st          -x,          r10       \n\t"
+        "st          -x,          r9        \n\t"
+        "st          -x,          r8        \n\t"
+        "st          -x,          r20       \n\t"
+        "st          -x,          r23       \n\t"
+        "st          -x,          r22       \n\t"
+        "st          -x,          r21       \n\t"
+        // --------------------------------------
+        "pop         r29        \n\t"
+        "pop         r28        \n\t"
+        "pop         r17        \n\t"
+        "pop         r16        \n\t"
+        "pop         r15        \n\t"
+        "pop         r14        \n\t"
+        "pop         r13        \n\t"
+        "pop         r12        \n\t"
+        "pop         r11        \n\t"
+        "pop         r10        \n\t"
+        "pop         r9         \n\t"
+        "pop         r8         \n\t"
+        "pop         r7         \n\t"
+        "pop         r6         \n\t"
+    :
+    : [ctx] "x" (ctx), [nRounds] "" (nRounds), [SBOX] "" (SBOX));
+}
+
 #elif defined MSP
 void Encrypt(uint8_t *block, uint8_t *roundKeys)
 {
@@ -272,8 +631,11 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
     /* r12     : temp use                    */
     /* r13     : currentRound                */
     /* r14     : point to round keys         */
-    /* r15     : point to block              */
+    /* r15     : point to block, then spare  */
     asm volatile(
+        #if defined(__MSP430X__)
+        "pushm       #8,        r11        \n\t"
+        #else
         "push        r4         \n\t"
         "push        r5         \n\t"
         "push        r6         \n\t"
@@ -282,105 +644,289 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "push        r9         \n\t"
         "push        r10        \n\t"
         "push        r11        \n\t"
-        "mov         #40,       r13          \n\t"
-        "mov         0(r15),    r4           \n\t"
-        "mov         2(r15),    r5           \n\t"
-        "mov         4(r15),    r6           \n\t"
-        "mov         6(r15),    r7           \n\t"
-        "mov         8(r15),    r8           \n\t"
-        "mov         10(r15),   r9           \n\t"
-        "mov         12(r15),   r10          \n\t"
-        "mov         14(r15),   r11          \n\t"
+        #endif
+        "mov         #40/" STR(UNROLL_FACTOR) ",       r13          \n\t"
+        // the rows are kept in the order left by MixColumns
+        "mov         0(r15),    r10          \n\t"
+        "mov         2(r15),    r11          \n\t"
+        "mov         4(r15),    r4           \n\t"
+        "mov         6(r15),    r5           \n\t"
+        "mov         8(r15),    r6           \n\t"
+        "mov         10(r15),   r7           \n\t"
+        "mov         12(r15),   r9           \n\t"
+        "mov         14(r15),   r8           \n\t"
+        "push        r15                     \n\t"
     "enc_loop:                               \n\t"
-        // SubCells, AddConstants, AddRoundTweakey and ShiftRows
-        "mov.b       r4,        r12          \n\t" // s0' = SBOX[s0]^(rks[0]^rc)
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
+        // SubCells. Each word is written to the register of its
+        // row in the order s0 ... s15 = r4 ... r11, which undoes
+        // the row rotation of MixColumns. r15 is the spare register.
+        "mov.b       r10,       r12          \n\t"
         "mov.b       SBOX(r12), r12          \n\t"
-        "xor.b       @r14+,     r12          \n\t"
-        "mov.b       r12,       0(r15)       \n\t"
-        "swpb        r4                      \n\t" // s1' = SBOX[s1]^rks[1]
-        "mov.b       r4,        r12          \n\t"
+        "swpb        r10                     \n\t"
+        "mov.b       r10,       r10          \n\t"
+        "mov.b       SBOX(r10), r15          \n\t"
+        "swpb        r15                     \n\t"
+        "bis         r12,       r15          \n\t"
+        "mov.b       r9,        r12          \n\t"
         "mov.b       SBOX(r12), r12          \n\t"
-        "xor.b       @r14+,     r12          \n\t"
-        "mov.b       r12,       1(r15)       \n\t"
-        "mov.b       r5,        r12          \n\t" // s2' = SBOX[s2]^rks[2]
+        "swpb        r9                      \n\t"
+        "mov.b       r9,        r9           \n\t"
+        "mov.b       SBOX(r9),  r10          \n\t"
+        "swpb        r10                     \n\t"
+        "bis         r12,       r10          \n\t"
+        "mov.b       r7,        r12          \n\t"
         "mov.b       SBOX(r12), r12          \n\t"
-        "xor.b       @r14+,     r12          \n\t"
-        "mov.b       r12,       2(r15)       \n\t"
-        "swpb        r5                      \n\t" // s3' = SBOX[s3]^rks[3]
+        "swpb        r7                      \n\t"
+        "mov.b       r7,        r7           \n\t"
+        "mov.b       SBOX(r7),  r9           \n\t"
+        "swpb        r9                      \n\t"
+        "bis         r12,       r9           \n\t"
         "mov.b       r5,        r12          \n\t"
         "mov.b       SBOX(r12), r12          \n\t"
-        "xor.b       @r14+,     r12          \n\t"
-        "mov.b       r12,       3(r15)       \n\t"
-        "mov.b       r6,        r12          \n\t" // s5' = SBOX[s4]^(rks[4]^rc)
+        "swpb        r5                      \n\t"
+        "mov.b       r5,        r5           \n\t"
+        "mov.b       SBOX(r5),  r7           \n\t"
+        "swpb        r7                      \n\t"
+        "bis         r12,       r7           \n\t"
+        "mov.b       r11,       r12          \n\t"
+        "mov.b       SBOX(r12), r12          \n\t"
+        "swpb        r11                     \n\t"
+        "mov.b       r11,       r11          \n\t"
+        "mov.b       SBOX(r11), r5           \n\t"
+        "swpb        r5                      \n\t"
+        "bis         r12,       r5           \n\t"
+        "mov.b       r8,        r12          \n\t"
+        "mov.b       SBOX(r12), r12          \n\t"
+        "swpb        r8                      \n\t"
+        "mov.b       r8,        r8           \n\t"
+        "mov.b       SBOX(r8),  r11          \n\t"
+        "swpb        r11                     \n\t"
+        "bis         r12,       r11          \n\t"
+        "mov.b       r6,        r12          \n\t"
         "mov.b       SBOX(r12), r12          \n\t"
-        "xor.b       @r14+,     r12          \n\t"
-        "mov.b       r12,       5(r15)       \n\t"
         "swpb        r6                      \n\t"
-        "mov.b       r6,        r12          \n\t" // s6' = SBOX[s5]^rks[s5]
+        "mov.b       r6,        r6           \n\t"
+        "mov.b       SBOX(r6),  r8           \n\t"
+        "swpb        r8                      \n\t"
+        "bis         r12,       r8           \n\t"
+        "mov.b       r4,        r12          \n\t"
         "mov.b       SBOX(r12), r12          \n\t"
-        "xor.b       @r14+,     r12          \n\t"
-        "mov.b       r12,       6(r15)       \n\t"
-        "mov.b       r7,        r12          \n\t" // s7' = SBOX[s6]^rks[s6]
+        "swpb        r4                      \n\t"
+        "mov.b       r4,        r4           \n\t"
+        "mov.b       SBOX(r4),  r6           \n\t"
+        "swpb        r6                      \n\t"
+        "bis         r12,       r6           \n\t"
+        "mov         r15,       r4           \n\t"
+        // AddConstants and AddRoundTweakey
+        "xor         @r14+,     r4           \n\t"
+        "xor         @r14+,     r5           \n\t"
+        "xor         @r14+,     r6           \n\t"
+        "xor         @r14+,     r7           \n\t"
+        "xor         #2,        r8           \n\t"
+        // ShiftRows: swpb and an exchange of the low (row 1) or high
+        // (row 3) bytes. The halves of row 2 are swapped by using
+        // (r9, r8) in MixColumns.
+        "swpb        r6                      \n\t"
+        "swpb        r7                      \n\t"
+        "mov         r6,        r12          \n\t"
+        "xor         r7,        r12          \n\t"
+        "and         #0x00ff,   r12          \n\t"
+        "xor         r12,       r6           \n\t"
+        "xor         r12,       r7           \n\t"
+        "swpb        r10                     \n\t"
+        "swpb        r11                     \n\t"
+        "mov         r10,       r12          \n\t"
+        "xor         r11,       r12          \n\t"
+        "and         #0xff00,   r12          \n\t"
+        "xor         r12,       r10          \n\t"
+        "xor         r12,       r11          \n\t"
+        // MixColumns
+        // xor  s4,  s8
+        // xor  s8,  s0
+        // xor  s12, s8
+        // the rows are left in (r10, r11), (r4, r5), (r6, r7), (r9, r8)
+        "xor         r9,        r6           \n\t"
+        "xor         r8,        r7           \n\t"
+        "xor         r4,        r9           \n\t"
+        "xor         r5,        r8           \n\t"
+        "xor         r9,        r10          \n\t"
+        "xor         r8,        r11          \n\t"
+        ".endr                  \n\t"
+    "dec             r13                     \n\t"
+    #if UNROLL_FACTOR > 1
+    "jeq             enc_exit                \n\t"
+    "br              #enc_loop               \n\t"
+    "enc_exit:                               \n\t"
+    #else
+    "jne             enc_loop                \n\t"
+    #endif
+        "pop         r15                     \n\t"
+        "mov         r10,       0(r15)       \n\t"
+        "mov         r11,       2(r15)       \n\t"
+        "mov         r4,        4(r15)       \n\t"
+        "mov         r5,        6(r15)       \n\t"
+        "mov         r6,        8(r15)       \n\t"
+        "mov         r7,        10(r15)      \n\t"
+        "mov         r9,        12(r15)      \n\t"
+        "mov         r8,        14(r15)      \n\t"
+        #if defined(__MSP430X__)
+        "popm        #8,        r11        \n\t"
+        #else
+        "pop         r11        \n\t"
+        "pop         r10        \n\t"
+        "pop         r9         \n\t"
+        "pop         r8         \n\t"
+        "pop         r7         \n\t"
+        "pop         r6         \n\t"
+        "pop         r5         \n\t"
+        "pop         r4         \n\t"
+        #endif
+    :
+    : [block] "m" (block), [roundKeys] "m" (roundKeys), [SBOX] "" (SBOX));
+}
+
+void EncryptStep(uint8_t *ctx, uint8_t nRounds)
+{
+    /* r4-r11  : cipher state                */
+    /* r12     : temp use                    */
+    /* r13     : currentRound                */
+    /* r14     : point to round keys         */
+    /* r15     : point to ctx  , then spare  */
+    asm volatile(
+        #if defined(__MSP430X__)
+        "pushm       #8,        r11        \n\t"
+        #else
+        "push        r4         \n\t"
+        "push        r5         \n\t"
+        "push        r6         \n\t"
+        "push        r7         \n\t"
+        "push        r8         \n\t"
+        "push        r9         \n\t"
+        "push        r10        \n\t"
+        "push        r11        \n\t"
+        #endif
+        "mov.b       r14,       r13          \n\t"
+        "mov         16(r15),   r14          \n\t"
+        "mov         0(r15),    r10          \n\t"
+        "mov         2(r15),    r11          \n\t"
+        "mov         4(r15),    r4           \n\t"
+        "mov         6(r15),    r5           \n\t"
+        "mov         8(r15),    r6           \n\t"
+        "mov         10(r15),   r7           \n\t"
+        "mov         12(r15),   r9           \n\t"
+        "mov         14(r15),   r8           \n\t"
+        "push        r15                     \n\t"
+    "step_loop:                              \n\t"
+        // SubCells. Each word is written to the register of its
+        // row in the order s0 ... s15 = r4 ... r11, which undoes
+        // the row rotation of MixColumns. r15 is the spare register.
+        "mov.b       r10,       r12          \n\t"
         "mov.b       SBOX(r12), r12          \n\t"
-        "xor.b       @r14+,     r12          \n\t"
-        "mov.b       r12,       7(r15)       \n\t"
-        "swpb        r7                      \n\t" // s4' = SBOX[s7]^rks[7]
+        "swpb        r10                     \n\t"
+        "mov.b       r10,       r10          \n\t"
+        "mov.b       SBOX(r10), r15          \n\t"
+        "swpb        r15                     \n\t"
+        "bis         r12,       r15          \n\t"
+        "mov.b       r9,        r12          \n\t"
+        "mov.b       SBOX(r12), r12          \n\t"
+        "swpb        r9                      \n\t"
+        "mov.b       r9,        r9           \n\t"
+        "mov.b       SBOX(r9),  r10          \n\t"
+        "swpb        r10                     \n\t"
+        "bis         r12,       r10          \n\t"
         "mov.b       r7,        r12          \n\t"
         "mov.b       SBOX(r12), r12          \n\t"
-        "xor.b       @r14+,     r12          \n\t"
-        "mov.b       r12,       4(r15)       \n\t"
-        "mov.b       r8,        r12          \n\t" // s10' = SBOX[s8]^rc
+        "swpb        r7                      \n\t"
+        "mov.b       r7,        r7           \n\t"
+        "mov.b       SBOX(r7),  r9           \n\t"
+        "swpb        r9                      \n\t"
+        "bis         r12,       r9           \n\t"
+        "mov.b       r5,        r12          \n\t"
         "mov.b       SBOX(r12), r12          \n\t"
-        "xor.b       #0x0002,   r12          \n\t"
-        "mov.b       r12,       10(r15)      \n\t" // s11' = SBOX[s9]
-        "swpb        r8                      \n\t"
-        "mov.b       r8,        r12          \n\t" // s8' = SBOX[s10]
-        "mov.b       SBOX(r12), 11(r15)      \n\t"
-        "mov.b       r9,        r12          \n\t"
-        "mov.b       SBOX(r12), 8(r15)       \n\t"
-        "swpb        r9                      \n\t" // s9' = SBOX[s11]
-        "mov.b       r9,        r12          \n\t"
-        "mov.b       SBOX(r12), 9(r15)       \n\t"
-        "mov.b       r10,       r12          \n\t" // s15' = SBOX[s12]
-        "mov.b       SBOX(r12), 15(r15)      \n\t"
-        "swpb        r10                     \n\t" // s12' = SBOX[s13]
-        "mov.b       r10,       r12          \n\t"
-        "mov.b       SBOX(r12), 12(r15)      \n\t"
-        "mov.b       r11,       r12          \n\t" // s13' = SBOX[s14]
-        "mov.b       SBOX(r12), 13(r15)      \n\t"
-        "swpb        r11                     \n\t" // s14' = SBOX[s15]
+        "swpb        r5                      \n\t"
+        "mov.b       r5,        r5           \n\t"
+        "mov.b       SBOX(r5),  r7           \n\t"
+        "swpb        r7                      \n\t"
+        "bis         r12,       r7           \n\t"
         "mov.b       r11,       r12          \n\t"
-        "mov.b       SBOX(r12), 14(r15)      \n\t"
+        "mov.b       SBOX(r12), r12          \n\t"
+        "swpb        r11                     \n\t"
+        "mov.b       r11,       r11          \n\t"
+        "mov.b       SBOX(r11), r5           \n\t"
+        "swpb        r5                      \n\t"
+        "bis         r12,       r5           \n\t"
+        "mov.b       r8,        r12          \n\t"
+        "mov.b       SBOX(r12), r12          \n\t"
+        "swpb        r8                      \n\t"
+        "mov.b       r8,        r8           \n\t"
+        "mov.b       SBOX(r8),  r11          \n\t"
+        "swpb        r11                     \n\t"
+        "bis         r12,       r11          \n\t"
+        "mov.b       r6,        r12          \n\t"
+        "mov.b       SBOX(r12), r12          \n\t"
+        "swpb        r6                      \n\t"
+        "mov.b       r6,        r6           \n\t"
+        "mov.b       SBOX(r6),  r8           \n\t"
+        "swpb        r8                      \n\t"
+        "bis         r12,       r8           \n\t"
+        "mov.b       r4,        r12          \n\t"
+        "mov.b       SBOX(r12), r12          \n\t"
+        "swpb        r4                      \n\t"
+        "mov.b       r4,        r4           \n\t"
+        "mov.b       SBOX(r4),  r6           \n\t"
+        "swpb        r6                      \n\t"
+        "bis         r12,       r6           \n\t"
+        "mov         r15,       r4           \n\t"
+        // AddConstants and AddRoundTweakey
+        "xor         @r14+,     r4           \n\t"
+        "xor         @r14+,     r5           \n\t"
+        "xor         @r14+,     r6           \n\t"
+        "xor         @r14+,     r7           \n\t"
+        "xor         #2,        r8           \n\t"
+        // ShiftRows: swpb and an exchange of the low (row 1) or high
+        // (row 3) bytes. The halves of row 2 are swapped by using
+        // (r9, r8) in MixColumns.
+        "swpb        r6                      \n\t"
+        "swpb        r7                      \n\t"
+        "mov         r6,        r12          \n\t"
+        "xor         r7,        r12          \n\t"
+        "and         #0x00ff,   r12          \n\t"
+        "xor         r12,       r6           \n\t"
+        "xor         r12,       r7           \n\t"
+        "swpb        r10                     \n\t"
+        "swpb        r11                     \n\t"
+        "mov         r10,       r12          \n\t"
+        "xor         r11,       r12          \n\t"
+        "and         #0xff00,   r12          \n\t"
+        "xor         r12,       r10          \n\t"
+        "xor         r12,       r11          \n\t"
         // MixColumns
-        // xor  s8,  s4
-        // xor  s0,  s8
-        // xor  s8,  s12
-        "mov         0(r15),    r6           \n\t"
-        "mov         2(r15),    r7           \n\t"
-        "mov         4(r15),    r8           \n\t"
-        "mov         6(r15),    r9           \n\t"
-        "mov         8(r15),    r10          \n\t"
-        "mov         10(r15),   r11          \n\t"
-        "mov         12(r15),   r4           \n\t"
-        "mov         14(r15),   r5           \n\t"
-        // part 1
-        "xor         r10,       r8           \n\t"
-        "xor         r6,        r10          \n\t"
-        "xor         r10,       r4           \n\t"
-        // part 2
-        "xor         r11,       r9           \n\t"
-        "xor         r7,        r11          \n\t"
-        "xor         r11,       r5           \n\t"
+        // xor  s4,  s8
+        // xor  s8,  s0
+        // xor  s12, s8
+        // the rows are left in (r10, r11), (r4, r5), (r6, r7), (r9, r8)
+        "xor         r9,        r6           \n\t"
+        "xor         r8,        r7           \n\t"
+        "xor         r4,        r9           \n\t"
+        "xor         r5,        r8           \n\t"
+        "xor         r9,        r10          \n\t"
+        "xor         r8,        r11          \n\t"
     "dec             r13                     \n\t"
-    "jne             enc_loop                \n\t"
-        "mov         r4,        0(r15)       \n\t"
-        "mov         r5,        2(r15)       \n\t"
-        "mov         r6,        4(r15)       \n\t"
-        "mov         r7,        6(r15)       \n\t"
-        "mov         r8,        8(r15)       \n\t"
-        "mov         r9,        10(r15)      \n\t"
-        "mov         r10,       12(r15)      \n\t"
-        "mov         r11,       14(r15)      \n\t"
+    "jne             step_loop               \n\t"
+        "pop         r15                     \n\t"
+        "mov         r10,       0(r15)       \n\t"
+        "mov         r11,       2(r15)       \n\t"
+        "mov         r4,        4(r15)       \n\t"
+        "mov         r5,        6(r15)       \n\t"
+        "mov         r6,        8(r15)       \n\t"
+        "mov         r7,        10(r15)      \n\t"
+        "mov         r9,        12(r15)      \n\t"
+        "mov         r8,        14(r15)      \n\t"
+        "mov         r14,       16(r15)      \n\t"
+        #if defined(__MSP430X__)
+        "popm        #8,        r11        \n\t"
+        #else
         "pop         r11        \n\t"
         "pop         r10        \n\t"
         "pop         r9         \n\t"
@@ -389,8 +935,9 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "pop         r6         \n\t"
         "pop         r5         \n\t"
         "pop         r4         \n\t"
+        #endif
     :
-    : [block] "m" (block), [roundKeys] "m" (roundKeys), [SBOX] "" (SBOX));
+    : [ctx] "m" (ctx), [nRounds] "m" (nRounds), [SBOX] "" (SBOX));
 }
 
 #elif defined ARM
@@ -405,11 +952,13 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
     // r10   : 0xff
     asm volatile(
         "stmdb      sp!,      {r2-r10}         \n\t"
-        "mov        r8,       #40              \n\t"
-        "ldr        r9,       =SBOX            \n\t"
+        "mov        r8,       #40/" STR(UNROLL_FACTOR) "              \n\t"
+        "movw       r9,       #:lower16:SBOX           \n\t"
+        "movt       r9,       #:upper16:SBOX           \n\t"
         "mov        r10,      #0xff            \n\t"
         "ldmia      r0,       {r2-r5}          \n\t" // load plaintext
     "enc_loop:                                 \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // SubCells
         // r2 (s3  s2  s1  s0)
         // r3 (s7  s6  s5  s4)
@@ -492,6 +1041,7 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "mov        r5,       r4               \n\t"
         "mov        r4,       r3               \n\t"
         "mov        r3,       r6               \n\t"
+        ".endr                  \n\t"
     "subs           r8,       r8, #1           \n\t"
     "bne            enc_loop                   \n\t"
         "stmia      r0,       {r2-r5}          \n\t" // store ciphertext
@@ -501,9 +1051,188 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
 }
 
 #else
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+/*
+ * One block in one XMM register, row i in the 32-bit lane i (s0 is the
+ * lowest byte). SBOX is evaluated on the 16 bytes at once with the
+ * NOR/XOR circuit of the specification, so there is no table lookup.
+ */
+static inline __m128i sbox_mix(__m128i x)
+{
+    __m128i t = _mm_or_si128(_mm_srli_epi32(x, 1), x);
+
+    t = _mm_andnot_si128(_mm_srli_epi32(t, 2), _mm_set1_epi32(0x11111111));
+    return _mm_xor_si128(x, t);
+}
+
+static inline __m128i sbox_permute(__m128i x)
+{
+    __m128i y;
+
+    y = _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x01010101)), 2);
+    y = _mm_or_si128(y, _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x06060606)), 5));
+    y = _mm_or_si128(y, _mm_srli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x20202020)), 5));
+    y = _mm_or_si128(y, _mm_srli_epi32(_mm_and_si128(x, _mm_set1_epi32(0xc8c8c8c8)), 2));
+    y = _mm_or_si128(y, _mm_srli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x10101010)), 1));
+    return y;
+}
+
+static inline __m128i SubCells(__m128i x)
+{
+    __m128i y;
+
+    x = sbox_mix(x);
+    x = sbox_permute(x);
+    x = sbox_mix(x);
+    x = sbox_permute(x);
+    x = sbox_mix(x);
+    x = sbox_permute(x);
+    x = sbox_mix(x);
+    // swap bit 1 and bit 2
+    y = _mm_and_si128(x, _mm_set1_epi32(0xf9f9f9f9));
+    y = _mm_or_si128(y, _mm_and_si128(_mm_srli_epi32(x, 1), _mm_set1_epi32(0x02020202)));
+    y = _mm_or_si128(y, _mm_and_si128(_mm_slli_epi32(x, 1), _mm_set1_epi32(0x04040404)));
+    return y;
+}
+
+static inline __m128i ShiftRows(__m128i x)
+{
+#if defined(__SSSE3__)
+    return _mm_shuffle_epi8(x, _mm_setr_epi8(0, 1, 2, 3, 7, 4, 5, 6,
+                                             10, 11, 8, 9, 13, 14, 15, 12));
+#else
+    // row i is rotated left by 8*i bits
+    __m128i r1 = _mm_or_si128(_mm_slli_epi32(x, 8), _mm_srli_epi32(x, 24));
+    __m128i r2 = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128i r3 = _mm_or_si128(_mm_slli_epi32(x, 24), _mm_srli_epi32(x, 8));
+
+    x = _mm_and_si128(x, _mm_setr_epi32(-1, 0, 0, 0));
+    x = _mm_or_si128(x, _mm_and_si128(r1, _mm_setr_epi32(0, -1, 0, 0)));
+    x = _mm_or_si128(x, _mm_and_si128(r2, _mm_setr_epi32(0, 0, -1, 0)));
+    x = _mm_or_si128(x, _mm_and_si128(r3, _mm_setr_epi32(0, 0, 0, -1)));
+    return x;
+#endif
+}
+
+static inline __m128i MixColumns(__m128i x)
+{
+    // (r0 ^ r2 ^ r3, r0, r1 ^ r2, r0 ^ r2)
+    __m128i a = _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 1, 0, 0));
+    __m128i b = _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 2, 0, 2));
+
+    b = _mm_and_si128(b, _mm_setr_epi32(-1, 0, -1, -1));
+    return _mm_xor_si128(_mm_xor_si128(a, b), _mm_srli_si128(x, 12));
+}
+
+void Encrypt(uint8_t *block, uint8_t *roundKeys)
+{
+    const __m128i c2 = _mm_setr_epi32(0, 0, 0x02, 0);
+    __m128i s = _mm_loadu_si128((__m128i *)block);
+    uint8_t i;
+
+    for (i = 0; i < 40; i++)
+    {
+        s = SubCells(s);
+        s = _mm_xor_si128(s, _mm_loadl_epi64((__m128i *)(roundKeys + 8 * i)));
+        s = _mm_xor_si128(s, c2);
+        s = ShiftRows(s);
+        s = MixColumns(s);
+    }
+    _mm_storeu_si128((__m128i *)block, s);
+}
+
+#else
+/*
+ * Portable version for hosts without SIMD: rows 0-1 in s[0] and rows
+ * 2-3 in s[1], row i in a 32-bit half with its first cell in the low
+ * byte. The SBOX circuit above is applied to 8 bytes per 64-bit word.
+ */
+static inline uint64_t sbox_mix(uint64_t x)
+{
+    return x ^ (~((x >> 3) | (x >> 2)) & 0x1111111111111111ULL);
+}
+
+static inline uint64_t sbox_permute(uint64_t x)
+{
+    return ((x & 0x0101010101010101ULL) << 2) |
+           ((x & 0x0606060606060606ULL) << 5) |
+           ((x & 0x2020202020202020ULL) >> 5) |
+           ((x & 0xc8c8c8c8c8c8c8c8ULL) >> 2) |
+           ((x & 0x1010101010101010ULL) >> 1);
+}
+
+static inline uint64_t SubCells(uint64_t x)
+{
+    x = sbox_mix(x);
+    x = sbox_permute(x);
+    x = sbox_mix(x);
+    x = sbox_permute(x);
+    x = sbox_mix(x);
+    x = sbox_permute(x);
+    x = sbox_mix(x);
+    // swap bit 1 and bit 2
+    return (x & 0xf9f9f9f9f9f9f9f9ULL) |
+           ((x >> 1) & 0x0202020202020202ULL) |
+           ((x << 1) & 0x0404040404040404ULL);
+}
+
+static inline void ShiftRows(uint64_t *s)
+{
+    // row i is rotated left by 8*i bits
+    s[0] = (s[0] & 0x00000000ffffffffULL) |
+           ((s[0] << 8) & 0xffffff0000000000ULL) |
+           ((s[0] >> 24) & 0x000000ff00000000ULL);
+    s[1] = ((s[1] << 16) & 0x00000000ffff0000ULL) |
+           ((s[1] >> 16) & 0x000000000000ffffULL) |
+           ((s[1] << 24) & 0xff00000000000000ULL) |
+           ((s[1] >> 8) & 0x00ffffff00000000ULL);
+}
+
+static inline void MixColumns(uint64_t *s)
+{
+    uint32_t r0 = s[0], r1 = s[0] >> 32, r2 = s[1], r3 = s[1] >> 32;
+
+    r1 ^= r2;
+    r2 ^= r0;
+    r3 ^= r2;
+    s[0] = ((uint64_t)r0 << 32) | r3;
+    s[1] = ((uint64_t)r2 << 32) | r1;
+}
+
 void Encrypt(uint8_t *block, uint8_t *roundKeys)
 {
-    /* Add here the cipher encryption implementation */
+    uint64_t s[2], k;
+    uint8_t i, j;
+
+    s[0] = s[1] = 0;
+    for (j = 8; j > 0; j--)
+    {
+        s[0] = (s[0] << 8) | block[j - 1];
+        s[1] = (s[1] << 8) | block[j + 7];
+    }
+    for (i = 0; i < 40; i++)
+    {
+        k = 0;
+        for (j = 8; j > 0; j--)
+        {
+            k = (k << 8) | roundKeys[8 * i + j - 1];
+        }
+        s[0] = SubCells(s[0]) ^ k;
+        s[1] = SubCells(s[1]) ^ 0x02;
+        ShiftRows(s);
+        MixColumns(s);
+    }
+    for (j = 0; j < 8; j++)
+    {
+        block[j] = s[0] >> (8 * j);
+        block[j + 8] = s[1] >> (8 * j);
+    }
 }
 
 #endif
+#endif
@@ -162,8 +162,7 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
 void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
 {
     /* r4-r11  : key state                   */
-    /* r12     : temp use                    */
-    /* r13     : currentRound                */
+    /* r12-r13 : temp use                    */
     /* r14     : point to roundKeys          */
     /* r15     : point to key and RC         */
     asm volatile (
@@ -173,6 +172,9 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
          *     the first is passed in R15 and the second is passed in R14.
          * [r11-r4]:  r11-r4 must be pushed if used.
          */
+        #if defined(__MSP430X__)
+        "pushm        #8,           r11           \n\t"
+        #else
         "push         r4            \n\t"
         "push         r5            \n\t"
         "push         r6            \n\t"
@@ -181,6 +183,7 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "push         r9            \n\t"
         "push         r10           \n\t"
         "push         r11           \n\t"
+        #endif
         // k0  k1  k2  k3         k9  k15 k8  k13
         // k4  k5  k6  k7         k10 k14 k12 k11
         // k8  k9  k10 k11 -----> k0  k1  k2  k3
@@ -197,67 +200,111 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "mov          @r15+,        r9            \n\t"
         "mov          @r15+,        r10           \n\t"
         "mov          @r15+,        r11           \n\t"
-        "sub          #8,           r1            \n\t"
         "mov          %[RC],        r15           \n\t"
-        "mov          #40,          r13           \n\t"
     "extend_loop:                                 \n\t"
+        // Two rounds per loop. The permutation is done in place on rows 2-3,
+        // so rows 0-1 are in r4-r7 in even rounds and in r8-r11 in odd rounds.
         // load round const
         "mov.b        @r15+,        r12           \n\t"
-        "mov          r12,          0(r1)         \n\t"
+        "mov          r12,          r13           \n\t"
         // k0 eor
-        "and          #0x000f,      r12           \n\t"
-        "xor          r4,           r12           \n\t"
+        "and          #0x000f,      r13           \n\t"
+        "xor          r4,           r13           \n\t"
         // store the first 4 bytes
-        "mov          r12,          0(r14)        \n\t"
+        "mov          r13,          0(r14)        \n\t"
         "mov          r5,           2(r14)        \n\t"
         // k4 eor
-        "mov          0(r1),        r12           \n\t"
         "and          #0x0030,      r12           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #4,           r12           \n\t"
+        #else
         "rra          r12                         \n\t"
         "rra          r12                         \n\t"
         "rra          r12                         \n\t"
         "rra          r12                         \n\t"
+        #endif
         "xor          r6,           r12           \n\t"
         // store the second 4 bytes
         "mov          r12,          4(r14)        \n\t"
         "mov          r7,           6(r14)        \n\t"
         "add          #8,           r14           \n\t"
-        // state change
-        // r4 (k1  k0)  r5 (k3  k2)         r4 (k15 k9)  r5 (k13 k8)
-        // r6 (k5  k4)  r7 (k7  k6)         r6 (k14 k10) r7 (k11 k12)
-        // r8 (k9  k8)  r9 (k11 k10) -----> r8 (k1  k0)  r9 (k3  k2)
-        // r10(k13 k12) r11(k15 k14)        r10(k5  k4)  r11(k7  k6)
-        "mov          r8,           0(r1)         \n\t"
-        "mov          r9,           2(r1)         \n\t"
-        "mov          r10,          4(r1)         \n\t"
-        "mov          r11,          6(r1)         \n\t"
-        "mov          r4,           r8            \n\t"
-        "mov          r5,           r9            \n\t"
-        "mov          r6,           r10           \n\t"
-        "mov          r7,           r11           \n\t"
-        "mov          0(r1),        r4            \n\t"
-        "mov.b        r4,           r5            \n\t"
+        // permutation of rows 2-3
+        // r8 (k9  k8)  r9 (k11 k10)         r8 (k15 k9)  r9 (k13 k8)
+        // r10(k13 k12) r11(k15 k14) -----> r10(k14 k10) r11(k11 k12)
+        "mov          r8,           r12           \n\t"
+        "swpb         r8                          \n\t"
+        "mov.b        r8,           r8            \n\t"
+        "mov          r11,          r13           \n\t"
+        "and          #0xff00,      r13           \n\t"
+        "bis          r13,          r8            \n\t"
+        "mov          r9,           r13           \n\t"
+        "mov          r10,          r9            \n\t"
+        "and          #0xff00,      r9            \n\t"
+        "mov.b        r12,          r12           \n\t"
+        "bis          r12,          r9            \n\t"
+        "mov          r10,          r12           \n\t"
+        "mov.b        r11,          r10           \n\t"
+        "swpb         r10                         \n\t"
+        "mov          r13,          r11           \n\t"
+        "and          #0xff00,      r11           \n\t"
+        "mov.b        r12,          r12           \n\t"
+        "bis          r12,          r11           \n\t"
+        "mov.b        r13,          r13           \n\t"
+        "bis          r13,          r10           \n\t"
+        // odd round: load round const
+        "mov.b        @r15+,        r12           \n\t"
+        "mov          r12,          r13           \n\t"
+        // k0 eor
+        "and          #0x000f,      r13           \n\t"
+        "xor          r8,           r13           \n\t"
+        // store the first 4 bytes
+        "mov          r13,          0(r14)        \n\t"
+        "mov          r9,           2(r14)        \n\t"
+        // k4 eor
+        "and          #0x0030,      r12           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #4,           r12           \n\t"
+        #else
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        #endif
+        "xor          r10,          r12           \n\t"
+        // store the second 4 bytes
+        "mov          r12,          4(r14)        \n\t"
+        "mov          r11,          6(r14)        \n\t"
+        "add          #8,           r14           \n\t"
+        // permutation of rows 2-3
+        // r4 (k9  k8)  r5 (k11 k10)         r4 (k15 k9)  r5 (k13 k8)
+        // r6 (k13 k12) r7 (k15 k14) -----> r6 (k14 k10) r7 (k11 k12)
+        "mov          r4,           r12           \n\t"
         "swpb         r4                          \n\t"
-        "and          #0x00ff,      r4            \n\t"
-        "mov          6(r1),        r12           \n\t"
-        "mov.b        r12,          r6            \n\t"
-        "and          #0xff00,      r12           \n\t"
-        "xor          r12,          r4            \n\t"
+        "mov.b        r4,           r4            \n\t"
+        "mov          r7,           r13           \n\t"
+        "and          #0xff00,      r13           \n\t"
+        "bis          r13,          r4            \n\t"
+        "mov          r5,           r13           \n\t"
+        "mov          r6,           r5            \n\t"
+        "and          #0xff00,      r5            \n\t"
+        "mov.b        r12,          r12           \n\t"
+        "bis          r12,          r5            \n\t"
+        "mov          r6,           r12           \n\t"
+        "mov.b        r7,           r6            \n\t"
         "swpb         r6                          \n\t"
-        "mov          4(r1),        r12           \n\t"
-        "mov.b        r12,          r7            \n\t"
-        "and          #0xff00,      r12           \n\t"
-        "xor          r12,          r5            \n\t"
-        "mov          2(r1),        r12           \n\t"
-        "and          #0xff00,      r12           \n\t"
-        "xor          r12,          r7            \n\t"
-        "mov          2(r1),        r12           \n\t"
-        "and          #0x00ff,      r12           \n\t"
-        "xor          r12,          r6            \n\t"
-        "dec          r13                         \n\t"
+        "mov          r13,          r7            \n\t"
+        "and          #0xff00,      r7            \n\t"
+        "mov.b        r12,          r12           \n\t"
+        "bis          r12,          r7            \n\t"
+        "mov.b        r13,          r13           \n\t"
+        "bis          r13,          r6            \n\t"
+        // stop after the last round constant
+        "cmp          #RC+40,       r15           \n\t"
         "jne          extend_loop                 \n\t"
-        "add          #8,           r1            \n\t"
         /* ----------------------------------------- */
+        #if defined(__MSP430X__)
+        "popm         #8,           r11           \n\t"
+        #else
         "pop          r11           \n\t"
         "pop          r10           \n\t"
         "pop          r9            \n\t"
@@ -266,6 +313,7 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "pop          r6            \n\t"
         "pop          r5            \n\t"
         "pop          r4            \n\t"    
+        #endif
     :
     : [key] "m" (key), [roundKeys] "m" (roundKeys), [RC] "" (RC));
 }
@@ -316,10 +364,73 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
     : [key] "r" (key), [roundKeys] "r" (roundKeys), [RC] "" (RC));
 }
 
+#else
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    /*
+     * TK1 in one XMM register, so PT is a single pshufb. Four rounds
+     * are stored per iteration from TK1 permuted by PT^0 ... PT^3.
+     */
+    const __m128i pt = _mm_setr_epi8(9, 15, 8, 13, 10, 14, 12, 11, 0, 1, 2, 3, 4, 5, 6, 7);
+    const __m128i pt2 = _mm_setr_epi8(1, 7, 0, 5, 2, 6, 4, 3, 9, 15, 8, 13, 10, 14, 12, 11);
+    __m128i tk0 = _mm_loadu_si128((__m128i *)key);
+    __m128i tk1, tk2, tk3, rc;
+    uint8_t i;
+
+    for (i = 0; i < 40; i += 4)
+    {
+        tk1 = _mm_shuffle_epi8(tk0, pt);
+        tk2 = _mm_shuffle_epi8(tk0, pt2);
+        tk3 = _mm_shuffle_epi8(tk1, pt2);
+        // c0 in byte 0 and c1 in byte 4 of each round
+        rc = _mm_setr_epi32(RC[i] & 0x0f, (RC[i] >> 4) & 0x03,
+                            RC[i + 1] & 0x0f, (RC[i + 1] >> 4) & 0x03);
+        _mm_storeu_si128((__m128i *)(roundKeys + 8 * i),
+                         _mm_xor_si128(_mm_unpacklo_epi64(tk0, tk1), rc));
+        rc = _mm_setr_epi32(RC[i + 2] & 0x0f, (RC[i + 2] >> 4) & 0x03,
+                            RC[i + 3] & 0x0f, (RC[i + 3] >> 4) & 0x03);
+        _mm_storeu_si128((__m128i *)(roundKeys + 8 * i + 16),
+                         _mm_xor_si128(_mm_unpacklo_epi64(tk2, tk3), rc));
+        tk0 = _mm_shuffle_epi8(tk2, pt2);
+    }
+}
+
 #else
 void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
 {
-    /* Add here the cipher encryption key schedule implementation */
+    /*
+     * Same layout as the assembly versions: the first two rows of TK1
+     * with c0 and c1 added, 8 bytes per round.
+     */
+    static const uint8_t PT[16] = {9, 15, 8, 13, 10, 14, 12, 11, 0, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t tk[16], tmp[16];
+    uint8_t i, j;
+
+    for (j = 0; j < 16; j++)
+    {
+        tk[j] = key[j];
+    }
+    for (i = 0; i < 40; i++)
+    {
+        for (j = 0; j < 8; j++)
+        {
+            roundKeys[8 * i + j] = tk[j];
+        }
+        roundKeys[8 * i + 0] ^= RC[i] & 0x0f;
+        roundKeys[8 * i + 4] ^= (RC[i] >> 4) & 0x03;
+        for (j = 0; j < 16; j++)
+        {
+            tmp[j] = tk[PT[j]];
+        }
+        for (j = 0; j < 16; j++)
+        {
+            tk[j] = tmp[j];
+        }
+    }
 }
 
-#endif
\ No newline at end of file
+#endif
+#endif
@@ -37,6 +37,23 @@
 #include "cipher.h"
 #include "constants.h"
 
+/*
+ * Rounds per iteration of the round loop. The round body is repeated
+ * by the assembler (.rept), so this trades code size for loop overhead.
+ * If it equals the number of rounds, the AVR code has no round counter
+ * and no branch back.
+ */
+#ifndef UNROLL_FACTOR
+#define UNROLL_FACTOR 1
+#endif
+
+#if (36 % UNROLL_FACTOR) != 0
+#error "UNROLL_FACTOR must divide the number of rounds"
+#endif
+
+#define STR_(x) #x
+#define STR(x)  STR_(x)
+
 #ifdef AVR
 void Decrypt(uint8_t *block, uint8_t *roundKeys)
 {
@@ -82,11 +99,107 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         // Init
         "adiw        r28,          63        \n\t"
         "adiw        r28,          63        \n\t"
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
         "adiw        r28,          14        \n\t"
-        "ldi         r24,          36        \n\t"
+        #else
+        // end of the last round keys, they are read with pre-decrement
+        "adiw        r28,          18        \n\t"
+        #endif
         "ldi         r25,          0x20      \n\t"
         "ldi         r31,          hi8(INV_SBOX)\n\t"
+        #if defined(SPEED_MODE)
+        // Fully unrolled. SubCells is done in place and the row
+        // rotation left by the inverse round is done by renaming:
+        // dec_round takes the register pairs holding the four rows.
+        // The order repeats every 8 rounds.
+        ".macro      dec_round a0, a1, b0, b1, c0, c1, d0, d1 \n\t"
+        // Inverse MixColumns
+        "eor         \\a0,        \\d0      \n\t"
+        "eor         \\d0,        \\b0      \n\t"
+        "eor         \\c0,        \\d0      \n\t"
+        "eor         \\a1,        \\d1      \n\t"
+        "eor         \\d1,        \\b1      \n\t"
+        "eor         \\c1,        \\d1      \n\t"
+        // Inverse ShiftRows, the second row is left to the renaming
+        "swap        \\c0                   \n\t"
+        "swap        \\c1                   \n\t"
+        "mov         r22,         \\c0      \n\t"
+        "eor         r22,         \\c1      \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         \\c0,        r22       \n\t"
+        "eor         \\c1,        r22       \n\t"
+        "swap        \\a0                   \n\t"
+        "swap        \\a1                   \n\t"
+        "mov         r22,         \\a0      \n\t"
+        "eor         r22,         \\a1      \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         \\a0,        r22       \n\t"
+        "eor         \\a1,        r22       \n\t"
+        // Inverse AddRoundTweakey and Inverse AddConstants
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "movw        r30,         r28       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\b0,        r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\b1,        r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\c0,        r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\c1,        r22       \n\t"
+        "eor         \\d1,        r25       \n\t"
+        "sbiw        r30,         8         \n\t"
+        "movw        r28,         r30       \n\t"
+        "ldi         r31,         hi8(INV_SBOX)\n\t"
+        #else
+        "ld          r22,         -y        \n\t"
+        "eor         \\c1,        r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         \\c0,        r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         \\b1,        r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         \\b0,        r22       \n\t"
+        "eor         \\d1,        r25       \n\t"
+        #endif
+        // Inverse SubCells, in place
+        "mov         r30,         \\a0      \n\t"
+        "lpm         \\a0,        z         \n\t"
+        "mov         r30,         \\a1      \n\t"
+        "lpm         \\a1,        z         \n\t"
+        "mov         r30,         \\b0      \n\t"
+        "lpm         \\b0,        z         \n\t"
+        "mov         r30,         \\b1      \n\t"
+        "lpm         \\b1,        z         \n\t"
+        "mov         r30,         \\c0      \n\t"
+        "lpm         \\c0,        z         \n\t"
+        "mov         r30,         \\c1      \n\t"
+        "lpm         \\c1,        z         \n\t"
+        "mov         r30,         \\d0      \n\t"
+        "lpm         \\d0,        z         \n\t"
+        "mov         r30,         \\d1      \n\t"
+        "lpm         \\d1,        z         \n\t"
+        ".endm       \n\t"
+        ".rept       4                      \n\t"
+        "dec_round   r14, r15, r16, r17, r18, r19, r20, r21 \n\t"
+        "dec_round   r16, r17, r18, r19, r21, r20, r14, r15 \n\t"
+        "dec_round   r18, r19, r21, r20, r15, r14, r16, r17 \n\t"
+        "dec_round   r21, r20, r15, r14, r17, r16, r18, r19 \n\t"
+        "dec_round   r15, r14, r17, r16, r19, r18, r21, r20 \n\t"
+        "dec_round   r17, r16, r19, r18, r20, r21, r15, r14 \n\t"
+        "dec_round   r19, r18, r20, r21, r14, r15, r17, r16 \n\t"
+        "dec_round   r20, r21, r14, r15, r16, r17, r19, r18 \n\t"
+        ".endr       \n\t"
+        "dec_round   r14, r15, r16, r17, r18, r19, r20, r21 \n\t"
+        "dec_round   r16, r17, r18, r19, r21, r20, r14, r15 \n\t"
+        "dec_round   r18, r19, r21, r20, r15, r14, r16, r17 \n\t"
+        "dec_round   r21, r20, r15, r14, r17, r16, r18, r19 \n\t"
+        ".purgem     dec_round              \n\t"
+        #else
+        #if UNROLL_FACTOR < 36
+        "ldi         r24,          36/" STR(UNROLL_FACTOR) "        \n\t"
+        #endif
     "dec_loop:                               \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // Inverse MixColumns
         // eor s0,  s12
         // eor s12, s4
@@ -127,20 +240,19 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         "sbiw        r30,         8          \n\t"
         "movw        r28,         r30        \n\t"
         #else
-        "ld          r22,         y+         \n\t"
-        "eor         r16,         r22        \n\t"
-        "ld          r22,         y+         \n\t"
-        "eor         r17,         r22        \n\t"
-        "ld          r22,         y+         \n\t"
-        "eor         r18,         r22        \n\t"
-        "ld          r22,         y+         \n\t"
+        "ld          r22,         -y         \n\t"
         "eor         r19,         r22        \n\t"
+        "ld          r22,         -y         \n\t"
+        "eor         r18,         r22        \n\t"
+        "ld          r22,         -y         \n\t"
+        "eor         r17,         r22        \n\t"
+        "ld          r22,         -y         \n\t"
+        "eor         r16,         r22        \n\t"
         "eor         r21,         r25        \n\t"
-        "sbiw        r28,         8          \n\t"
         #endif
         // Inverse SubCells
         #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
-        "ldi         r31,         hi8(SBOX)  \n\t"
+        "ldi         r31,         hi8(INV_SBOX)\n\t"
         #endif
         "movw        r22,         r14        \n\t"
         "mov         r30,         r16        \n\t"
@@ -159,9 +271,29 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         "lpm         r20,         z          \n\t"
         "mov         r30,         r23        \n\t"
         "lpm         r21,         z          \n\t"
+        ".endr                  \n\t"
+    #if UNROLL_FACTOR < 36
     "dec             r24                     \n\t"
+    #if UNROLL_FACTOR > 1
+    "breq            dec_exit                \n\t"
+    "rjmp            dec_loop                \n\t"
+    "dec_exit:                               \n\t"
+    #else
     "brne            dec_loop                \n\t"
+    #endif
+    #endif
+        #endif
         // Store cipher text
+        #if defined(SPEED_MODE)
+        "st          x,           r20        \n\t"
+        "st          -x,          r21        \n\t"
+        "st          -x,          r18        \n\t"
+        "st          -x,          r19        \n\t"
+        "st          -x,          r16        \n\t"
+        "st          -x,          r17        \n\t"
+        "st          -x,          r14        \n\t"
+        "st          -x,          r15        \n\t"
+        #else
         "st          x,           r21        \n\t"
         "st          -x,          r20        \n\t"
         "st          -x,          r19        \n\t"
@@ -170,6 +302,7 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         "st          -x,          r16        \n\t"
         "st          -x,          r15        \n\t"
         "st          -x,          r14        \n\t"
+        #endif
         "pop         r29        \n\t"
         "pop         r28        \n\t"
         "pop         r17        \n\t"
@@ -180,6 +313,229 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
     : [block] "x" (block), [roundKeys] "" (roundKeys), [INV_SBOX] "" (INV_SBOX));
 }
 
+void Decrypt2(uint8_t *block, uint8_t *roundKeys)
+{
+    /*--------------------------------------*/
+    /* r14-r21  : first cipher text         */
+    /* r6-r13   : second cipher text        */
+    /* r4-r5    : temp use (second block)   */
+    /* r22-r23  : temp use                  */
+    /* r24      : loop control              */
+    /* r25      : const 0x02                */
+    /* r26-r27  : X points to cipher text   */
+    /* r28-r29  : Y points to roundKeys     */
+    /* r30-r31  : Z points to INV_SBOX      */
+    /*--------------------------------------*/
+    asm volatile(
+        "push        r4         \n\t"
+        "push        r5         \n\t"
+        "push        r6         \n\t"
+        "push        r7         \n\t"
+        "push        r8         \n\t"
+        "push        r9         \n\t"
+        "push        r10        \n\t"
+        "push        r11        \n\t"
+        "push        r12        \n\t"
+        "push        r13        \n\t"
+        "push        r14        \n\t"
+        "push        r15        \n\t"
+        "push        r16        \n\t"
+        "push        r17        \n\t"
+        "push        r28        \n\t"
+        "push        r29        \n\t"
+        "movw        r28,         r22       \n\t"
+        // Load cipher text, the second block follows the first
+        "ld          r14,         x+        \n\t"
+        "ld          r15,         x+        \n\t"
+        "ld          r16,         x+        \n\t"
+        "ld          r17,         x+        \n\t"
+        "ld          r18,         x+        \n\t"
+        "ld          r19,         x+        \n\t"
+        "ld          r20,         x+        \n\t"
+        "ld          r21,         x+        \n\t"
+        "ld          r6,          x+        \n\t"
+        "ld          r7,          x+        \n\t"
+        "ld          r8,          x+        \n\t"
+        "ld          r9,          x+        \n\t"
+        "ld          r10,         x+        \n\t"
+        "ld          r11,         x+        \n\t"
+        "ld          r12,         x+        \n\t"
+        "ld          r13,         x         \n\t"
+        // Init
+        "adiw        r28,         63        \n\t"
+        "adiw        r28,         63        \n\t"
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "adiw        r28,         14        \n\t"
+        #else
+        // end of the last round keys, they are read with pre-decrement
+        "adiw        r28,         18        \n\t"
+        #endif
+        #if UNROLL_FACTOR < 36
+        "ldi         r24,         36/" STR(UNROLL_FACTOR) "        \n\t"
+        #endif
+        "ldi         r25,         0x20      \n\t"
+        "ldi         r31,         hi8(INV_SBOX)\n\t"
+    "dec2_loop:                             \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
+        // Inverse MixColumns
+        "eor         r14,         r20       \n\t"
+        "eor         r20,         r16       \n\t"
+        "eor         r18,         r20       \n\t"
+        "eor         r15,         r21       \n\t"
+        "eor         r21,         r17       \n\t"
+        "eor         r19,         r21       \n\t"
+        "eor         r6,          r12       \n\t"
+        "eor         r12,         r8        \n\t"
+        "eor         r10,         r12       \n\t"
+        "eor         r7,          r13       \n\t"
+        "eor         r13,         r9        \n\t"
+        "eor         r11,         r13       \n\t"
+        // Inverse ShiftRows
+        "swap        r18                    \n\t"
+        "swap        r19                    \n\t"
+        "mov         r22,         r18       \n\t"
+        "eor         r22,         r19       \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         r18,         r22       \n\t"
+        "eor         r19,         r22       \n\t"
+        "swap        r14                    \n\t"
+        "swap        r15                    \n\t"
+        "mov         r22,         r14       \n\t"
+        "eor         r22,         r15       \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         r14,         r22       \n\t"
+        "eor         r15,         r22       \n\t"
+        "swap        r10                    \n\t"
+        "swap        r11                    \n\t"
+        "mov         r22,         r10       \n\t"
+        "eor         r22,         r11       \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         r10,         r22       \n\t"
+        "eor         r11,         r22       \n\t"
+        "swap        r6                     \n\t"
+        "swap        r7                     \n\t"
+        "mov         r22,         r6        \n\t"
+        "eor         r22,         r7        \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         r6,          r22       \n\t"
+        "eor         r7,          r22       \n\t"
+        // Inverse AddRoundTweakey and Inverse AddConstants, the round keys are loaded once
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "movw        r30,         r28       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r16,         r22       \n\t"
+        "eor         r8,          r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r17,         r22       \n\t"
+        "eor         r9,          r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r18,         r22       \n\t"
+        "eor         r10,         r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r19,         r22       \n\t"
+        "eor         r11,         r22       \n\t"
+        "eor         r21,         r25       \n\t"
+        "eor         r13,         r25       \n\t"
+        "sbiw        r30,         8         \n\t"
+        "movw        r28,         r30       \n\t"
+        #else
+        "ld          r22,         -y        \n\t"
+        "eor         r19,         r22       \n\t"
+        "eor         r11,         r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         r18,         r22       \n\t"
+        "eor         r10,         r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         r17,         r22       \n\t"
+        "eor         r9,          r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         r16,         r22       \n\t"
+        "eor         r8,          r22       \n\t"
+        "eor         r21,         r25       \n\t"
+        "eor         r13,         r25       \n\t"
+        #endif
+        // Inverse SubCells
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "ldi         r31,         hi8(INV_SBOX)\n\t"
+        #endif
+        "movw        r22,         r14       \n\t"
+        "mov         r30,         r16       \n\t"
+        "lpm         r14,         z         \n\t"
+        "mov         r30,         r17       \n\t"
+        "lpm         r15,         z         \n\t"
+        "mov         r30,         r18       \n\t"
+        "lpm         r16,         z         \n\t"
+        "mov         r30,         r19       \n\t"
+        "lpm         r17,         z         \n\t"
+        "mov         r30,         r21       \n\t"
+        "lpm         r18,         z         \n\t"
+        "mov         r30,         r20       \n\t"
+        "lpm         r19,         z         \n\t"
+        "mov         r30,         r22       \n\t"
+        "lpm         r20,         z         \n\t"
+        "mov         r30,         r23       \n\t"
+        "lpm         r21,         z         \n\t"
+        "movw        r4,          r6        \n\t"
+        "mov         r30,         r8        \n\t"
+        "lpm         r6,          z         \n\t"
+        "mov         r30,         r9        \n\t"
+        "lpm         r7,          z         \n\t"
+        "mov         r30,         r10       \n\t"
+        "lpm         r8,          z         \n\t"
+        "mov         r30,         r11       \n\t"
+        "lpm         r9,          z         \n\t"
+        "mov         r30,         r13       \n\t"
+        "lpm         r10,         z         \n\t"
+        "mov         r30,         r12       \n\t"
+        "lpm         r11,         z         \n\t"
+        "mov         r30,         r4        \n\t"
+        "lpm         r12,         z         \n\t"
+        "mov         r30,         r5        \n\t"
+        "lpm         r13,         z         \n\t"
+        ".endr                  \n\t"
+    #if UNROLL_FACTOR < 36
+    "dec             r24                    \n\t"
+    "breq            dec2_exit              \n\t"
+    "rjmp            dec2_loop              \n\t"
+    "dec2_exit:                             \n\t"
+    #endif
+        // Store plain text
+        "st          x,           r13       \n\t"
+        "st          -x,          r12       \n\t"
+        "st          -x,          r11       \n\t"
+        "st          -x,          r10       \n\t"
+        "st          -x,          r9        \n\t"
+        "st          -x,          r8        \n\t"
+        "st          -x,          r7        \n\t"
+        "st          -x,          r6        \n\t"
+        "st          -x,          r21       \n\t"
+        "st          -x,          r20       \n\t"
+        "st          -x,          r19       \n\t"
+        "st          -x,          r18       \n\t"
+        "st          -x,          r17       \n\t"
+        "st          -x,          r16       \n\t"
+        "st          -x,          r15       \n\t"
+        "st          -x,          r14       \n\t"
+        "pop         r29        \n\t"
+        "pop         r28        \n\t"
+        "pop         r17        \n\t"
+        "pop         r16        \n\t"
+        "pop         r15        \n\t"
+        "pop         r14        \n\t"
+        "pop         r13        \n\t"
+        "pop         r12        \n\t"
+        "pop         r11        \n\t"
+        "pop         r10        \n\t"
+        "pop         r9         \n\t"
+        "pop         r8         \n\t"
+        "pop         r7         \n\t"
+        "pop         r6         \n\t"
+        "pop         r5         \n\t"
+        "pop         r4         \n\t"
+    :
+    : [block] "x" (block), [roundKeys] "" (roundKeys), [INV_SBOX] "" (INV_SBOX));
+}
+
 #elif defined MSP
 void Decrypt(uint8_t *block, uint8_t *roundKeys)
 {
@@ -189,20 +545,26 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
     /* r14     : point to round keys         */
     /* r15     : point to block              */
     asm volatile(
+        #if defined(__MSP430X__)
+        "pushm       #4,        r7         \n\t"
+        "pushm       #2,        r11        \n\t"
+        #else
         "push        r4         \n\t"
         "push        r5         \n\t"
         "push        r6         \n\t"
         "push        r7         \n\t"
         "push        r10        \n\t"
         "push        r11        \n\t"
+        #endif
         // Init
-        "mov         #36,           r13      \n\t"
+        "mov         #36/" STR(UNROLL_FACTOR) ",           r13      \n\t"
         "add         #140,          r14      \n\t"
         "mov         0(r15),        r4       \n\t"
         "mov         2(r15),        r5       \n\t"
         "mov         4(r15),        r6       \n\t"
         "mov         6(r15),        r7       \n\t"
     "dec_loop:                               \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // Inverse MixColumns
         // xor s12, s0 
         // xor s4,  s12
@@ -263,18 +625,30 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys)
         "xor         r11,           r7       \n\t" // fourth line        
         "mov         r10,           r4       \n\t"
         "sub         #8,            r14      \n\t"  
+        ".endr                  \n\t"
     "dec             r13                     \n\t"
+    #if UNROLL_FACTOR > 1
+    "jeq             dec_exit                \n\t"
+    "br              #dec_loop               \n\t"
+    "dec_exit:                               \n\t"
+    #else
     "jne             dec_loop                \n\t"
+    #endif
         "mov         r4,            0(r15),  \n\t"
         "mov         r5,            2(r15),  \n\t"
         "mov         r6,            4(r15),  \n\t"
         "mov         r7,            6(r15),  \n\t"
+        #if defined(__MSP430X__)
+        "popm        #2,        r11        \n\t"
+        "popm        #4,        r7         \n\t"
+        #else
         "pop         r11        \n\t"
         "pop         r10        \n\t"
         "pop         r7         \n\t"
         "pop         r6         \n\t"
         "pop         r5         \n\t"
         "pop         r4         \n\t"
+        #endif
     :
     : [block] "m" (block), [roundKeys] "m" (roundKeys), [INV_SBOX] "" (INV_SBOX));
 }
@@ -291,8 +665,9 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys) {
     // r10   : 0xff
     asm volatile(
         "stmdb      sp!,      {r2-r10}         \n\t"
-        "mov        r8,       #36              \n\t"
-        "ldr        r9,       =INV_SBOX        \n\t"
+        "mov        r8,       #36/" STR(UNROLL_FACTOR) "              \n\t"
+        "movw       r9,       #:lower16:INV_SBOX       \n\t"
+        "movt       r9,       #:upper16:INV_SBOX       \n\t"
         "mov        r10,      #0xff            \n\t"
         "adds       r1,       r1, #140         \n\t"
         // r2 (--  --  --  --  s2  s3  s0  s1)
@@ -303,6 +678,7 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys) {
         "mov        r3,       r2, lsr #16      \n\t"
         "mov        r5,       r4, lsr #16      \n\t"
     "enc_loop:                                 \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // Inverse MixColumns
         "eors       r2,       r2, r5           \n\t"
         "eors       r5,       r5, r3           \n\t"
@@ -350,6 +726,7 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys) {
         "bfi        r4,r6,    #8, #8           \n\t"
         // recover the first line
         "mov        r5,       r7               \n\t"
+        ".endr                  \n\t"
     "subs           r8,       r8, #1           \n\t"
     "bne            enc_loop                   \n\t"
         "bfi        r2,       r3, #16, #16     \n\t"
@@ -361,9 +738,81 @@ void Decrypt(uint8_t *block, uint8_t *roundKeys) {
 }
 
 #else
+/*
+ * Portable version for hosts without SIMD. The block is one 64-bit
+ * word with s0 in the top nibble, so row i is the 16-bit lane at bit
+ * 48 - 16*i.
+ */
+static inline uint64_t sbox_mix(uint64_t x)
+{
+    return x ^ (~((x >> 3) | (x >> 2)) & 0x1111111111111111ULL);
+}
+
+static inline uint64_t InvSubCells(uint64_t x)
+{
+    // x0 ^= ~(x3 | x2), then rotate each nibble right by one bit
+    x = sbox_mix(x);
+    x = ((x >> 1) & 0x7777777777777777ULL) | ((x << 3) & 0x8888888888888888ULL);
+    x = sbox_mix(x);
+    x = ((x >> 1) & 0x7777777777777777ULL) | ((x << 3) & 0x8888888888888888ULL);
+    x = sbox_mix(x);
+    x = ((x >> 1) & 0x7777777777777777ULL) | ((x << 3) & 0x8888888888888888ULL);
+    return sbox_mix(x);
+}
+
+static inline uint64_t InvShiftRows(uint64_t x)
+{
+    // row i is rotated left by 4*i bits
+    return (x & 0xffff000000000000ULL) |
+           ((x << 4) & 0x0000fff000000000ULL) |
+           ((x >> 12) & 0x0000000f00000000ULL) |
+           ((x >> 8) & 0x0000000000ff0000ULL) |
+           ((x << 8) & 0x00000000ff000000ULL) |
+           ((x >> 4) & 0x0000000000000fffULL) |
+           ((x << 12) & 0x000000000000f000ULL);
+}
+
+static inline uint64_t InvMixColumns(uint64_t x)
+{
+    uint16_t r0 = x >> 48, r1 = x >> 32, r2 = x >> 16, r3 = x;
+
+    r3 ^= r1;
+    r2 ^= r3;
+    r0 ^= r3 ^ r1;
+    return ((uint64_t)r1 << 48) | ((uint64_t)r2 << 32) | ((uint64_t)r3 << 16) | r0;
+}
+
 void Decrypt(uint8_t *block, uint8_t *roundKeys)
 {
-    /* Add here the cipher decryption implementation */
+    uint64_t s = 0;
+    uint32_t k;
+    uint8_t i;
+
+    for (i = 0; i < 8; i++)
+    {
+        s = (s << 8) | block[i];
+    }
+    for (i = 36; i > 0; i--)
+    {
+        k = ((uint32_t)roundKeys[4 * i - 4] << 24) | ((uint32_t)roundKeys[4 * i - 3] << 16) |
+            ((uint32_t)roundKeys[4 * i - 2] << 8) | roundKeys[4 * i - 1];
+        s = InvMixColumns(s);
+        s = InvShiftRows(s);
+        s = InvSubCells(s ^ ((uint64_t)k << 32) ^ 0x20000000);
+    }
+    for (i = 8; i > 0; i--)
+    {
+        block[i - 1] = s;
+        s >>= 8;
+    }
 }
 
 #endif
+
+#ifndef AVR
+void Decrypt2(uint8_t *block, uint8_t *roundKeys)
+{
+    Decrypt(block, roundKeys);
+    Decrypt(block + 8, roundKeys);
+}
+#endif
@@ -37,6 +37,23 @@
 #include "cipher.h"
 #include "constants.h"
 
+/*
+ * Rounds per iteration of the round loop. The round body is repeated
+ * by the assembler (.rept), so this trades code size for loop overhead.
+ * If it equals the number of rounds, the AVR code has no round counter
+ * and no branch back.
+ */
+#ifndef UNROLL_FACTOR
+#define UNROLL_FACTOR 1
+#endif
+
+#if (36 % UNROLL_FACTOR) != 0
+#error "UNROLL_FACTOR must divide the number of rounds"
+#endif
+
+#define STR_(x) #x
+#define STR(x)  STR_(x)
+
 #ifdef AVR
 void Encrypt(uint8_t *block, uint8_t *roundKeys)
 {
@@ -79,13 +96,105 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "ld          r17,         x+        \n\t"
         "ld          r19,         x+        \n\t"
         "ld          r18,         x         \n\t"
-        // set currentRound
-        "ldi         r24,         36        \n\t"
         // used for constant 0x02
         "ldi         r25,         0x20      \n\t"
         "ldi         r31,         hi8(SBOX) \n\t"
+        #if defined(SPEED_MODE)
+        // Fully unrolled. SubCells is done in place and the row
+        // rotation left by ShiftRows and MixColumns is done by renaming:
+        // enc_round takes the register pairs holding the four rows.
+        // The order repeats every 8 rounds.
+        ".macro      enc_round a0, a1, b0, b1, c0, c1, d0, d1 \n\t"
+        // SubCells, in place
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "ldi         r31,         hi8(SBOX) \n\t"
+        #endif
+        "mov         r30,         \\a0      \n\t"
+        "lpm         \\a0,        z         \n\t"
+        "mov         r30,         \\a1      \n\t"
+        "lpm         \\a1,        z         \n\t"
+        "mov         r30,         \\b0      \n\t"
+        "lpm         \\b0,        z         \n\t"
+        "mov         r30,         \\b1      \n\t"
+        "lpm         \\b1,        z         \n\t"
+        "mov         r30,         \\c0      \n\t"
+        "lpm         \\c0,        z         \n\t"
+        "mov         r30,         \\c1      \n\t"
+        "lpm         \\c1,        z         \n\t"
+        "mov         r30,         \\d0      \n\t"
+        "lpm         \\d0,        z         \n\t"
+        "mov         r30,         \\d1      \n\t"
+        "lpm         \\d1,        z         \n\t"
+        // AddConstants and AddRoundTweakey
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "movw        r30,         r28       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\a0,        r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\a1,        r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\b0,        r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\b1,        r22       \n\t"
+        "eor         \\c0,        r25       \n\t"
+        "movw        r28,         r30       \n\t"
+        #else
+        "ld          r22,         y+        \n\t"
+        "eor         \\a0,        r22       \n\t"
+        "ld          r22,         y+        \n\t"
+        "eor         \\a1,        r22       \n\t"
+        "ld          r22,         y+        \n\t"
+        "eor         \\b0,        r22       \n\t"
+        "ld          r22,         y+        \n\t"
+        "eor         \\b1,        r22       \n\t"
+        "eor         \\c0,        r25       \n\t"
+        #endif
+        // ShiftRows, the third row is left to the renaming
+        "swap        \\b0                   \n\t"
+        "swap        \\b1                   \n\t"
+        "mov         r22,         \\b0      \n\t"
+        "eor         r22,         \\b1      \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         \\b0,        r22       \n\t"
+        "eor         \\b1,        r22       \n\t"
+        "swap        \\d0                   \n\t"
+        "swap        \\d1                   \n\t"
+        "mov         r22,         \\d0      \n\t"
+        "eor         r22,         \\d1      \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         \\d0,        r22       \n\t"
+        "eor         \\d1,        r22       \n\t"
+        // MixColumns
+        "eor         \\b0,        \\c1      \n\t"
+        "eor         \\c1,        \\a0      \n\t"
+        "eor         \\d0,        \\c1      \n\t"
+        "eor         \\b1,        \\c0      \n\t"
+        "eor         \\c0,        \\a1      \n\t"
+        "eor         \\d1,        \\c0      \n\t"
+        ".endm       \n\t"
+        ".rept       4                      \n\t"
+        "enc_round   r20, r21, r14, r15, r16, r17, r19, r18 \n\t"
+        "enc_round   r19, r18, r20, r21, r14, r15, r17, r16 \n\t"
+        "enc_round   r17, r16, r19, r18, r20, r21, r15, r14 \n\t"
+        "enc_round   r15, r14, r17, r16, r19, r18, r21, r20 \n\t"
+        "enc_round   r21, r20, r15, r14, r17, r16, r18, r19 \n\t"
+        "enc_round   r18, r19, r21, r20, r15, r14, r16, r17 \n\t"
+        "enc_round   r16, r17, r18, r19, r21, r20, r14, r15 \n\t"
+        "enc_round   r14, r15, r16, r17, r18, r19, r20, r21 \n\t"
+        ".endr       \n\t"
+        "enc_round   r20, r21, r14, r15, r16, r17, r19, r18 \n\t"
+        "enc_round   r19, r18, r20, r21, r14, r15, r17, r16 \n\t"
+        "enc_round   r17, r16, r19, r18, r20, r21, r15, r14 \n\t"
+        "enc_round   r15, r14, r17, r16, r19, r18, r21, r20 \n\t"
+        ".purgem     enc_round              \n\t"
+        #else
+        #if UNROLL_FACTOR < 36
+        // set currentRound
+        "ldi         r24,         36/" STR(UNROLL_FACTOR) "        \n\t"
+        #endif
         // encryption
     "enc_loop:                              \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // SubCells
         #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
         "ldi         r31,         hi8(SBOX) \n\t"
@@ -153,9 +262,29 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "eor         r17,         r18       \n\t"
         "eor         r18,         r15       \n\t"
         "eor         r21,         r18       \n\t"
+        ".endr                  \n\t"
+    #if UNROLL_FACTOR < 36
     "dec             r24                    \n\t"
+    #if UNROLL_FACTOR > 1
+    "breq            enc_exit               \n\t"
+    "rjmp            enc_loop               \n\t"
+    "enc_exit:                              \n\t"
+    #else
     "brne            enc_loop               \n\t"
+    #endif
+    #endif
+        #endif
         // Store cipher text
+        #if defined(SPEED_MODE)
+        "st          x,           r19       \n\t"
+        "st          -x,          r18       \n\t"
+        "st          -x,          r16       \n\t"
+        "st          -x,          r17       \n\t"
+        "st          -x,          r14       \n\t"
+        "st          -x,          r15       \n\t"
+        "st          -x,          r20       \n\t"
+        "st          -x,          r21       \n\t"
+        #else
         "st          x,           r18       \n\t"
         "st          -x,          r19       \n\t"
         "st          -x,          r17       \n\t"
@@ -164,6 +293,7 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "st          -x,          r14       \n\t"
         "st          -x,          r21       \n\t"
         "st          -x,          r20       \n\t"
+        #endif
         "pop         r29        \n\t"
         "pop         r28        \n\t"
         "pop         r17        \n\t"
@@ -174,6 +304,353 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
     : [block] "x" (block), [roundKeys] "" (roundKeys), [SBOX] "" (SBOX));
 }
 
+void Encrypt2(uint8_t *block, uint8_t *roundKeys)
+{
+    /*--------------------------------------*/
+    /* r14-r21  : first plain text          */
+    /* r6-r13   : second plain text         */
+    /* r4-r5    : temp use (second block)   */
+    /* r22-r23  : temp use                  */
+    /* r24      : loop control              */
+    /* r25      : const 0x02                */
+    /* r26-r27  : X points to plain text    */
+    /* r28-r29  : Y points to roundKeys     */
+    /* r30-r31  : Z points to SBOX          */
+    /*--------------------------------------*/
+    asm volatile(
+        "push        r4         \n\t"
+        "push        r5         \n\t"
+        "push        r6         \n\t"
+        "push        r7         \n\t"
+        "push        r8         \n\t"
+        "push        r9         \n\t"
+        "push        r10        \n\t"
+        "push        r11        \n\t"
+        "push        r12        \n\t"
+        "push        r13        \n\t"
+        "push        r14        \n\t"
+        "push        r15        \n\t"
+        "push        r16        \n\t"
+        "push        r17        \n\t"
+        "push        r28        \n\t"
+        "push        r29        \n\t"
+        "movw        r28,         r22       \n\t"
+        // Load plain text, the second block follows the first
+        "ld          r20,         x+        \n\t"
+        "ld          r21,         x+        \n\t"
+        "ld          r14,         x+        \n\t"
+        "ld          r15,         x+        \n\t"
+        "ld          r16,         x+        \n\t"
+        "ld          r17,         x+        \n\t"
+        "ld          r19,         x+        \n\t"
+        "ld          r18,         x+        \n\t"
+        "ld          r12,         x+        \n\t"
+        "ld          r13,         x+        \n\t"
+        "ld          r6,          x+        \n\t"
+        "ld          r7,          x+        \n\t"
+        "ld          r8,          x+        \n\t"
+        "ld          r9,          x+        \n\t"
+        "ld          r11,         x+        \n\t"
+        "ld          r10,         x         \n\t"
+        #if UNROLL_FACTOR < 36
+        // set currentRound
+        "ldi         r24,         36/" STR(UNROLL_FACTOR) "        \n\t"
+        #endif
+        // used for constant 0x02
+        "ldi         r25,         0x20      \n\t"
+        "ldi         r31,         hi8(SBOX) \n\t"
+        // encryption
+    "enc2_loop:                             \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
+        // SubCells
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "ldi         r31,         hi8(SBOX) \n\t"
+        #endif
+        "movw        r22,         r20       \n\t"
+        "mov         r30,         r19       \n\t"
+        "lpm         r20,         z         \n\t"
+        "mov         r30,         r18       \n\t"
+        "lpm         r21,         z         \n\t"
+        "mov         r30,         r16       \n\t"
+        "lpm         r18,         z         \n\t"
+        "mov         r30,         r17       \n\t"
+        "lpm         r19,         z         \n\t"
+        "mov         r30,         r14       \n\t"
+        "lpm         r16,         z         \n\t"
+        "mov         r30,         r15       \n\t"
+        "lpm         r17,         z         \n\t"
+        "mov         r30,         r22       \n\t"
+        "lpm         r14,         z         \n\t"
+        "mov         r30,         r23       \n\t"
+        "lpm         r15,         z         \n\t"
+        "movw        r4,          r12       \n\t"
+        "mov         r30,         r11       \n\t"
+        "lpm         r12,         z         \n\t"
+        "mov         r30,         r10       \n\t"
+        "lpm         r13,         z         \n\t"
+        "mov         r30,         r8        \n\t"
+        "lpm         r10,         z         \n\t"
+        "mov         r30,         r9        \n\t"
+        "lpm         r11,         z         \n\t"
+        "mov         r30,         r6        \n\t"
+        "lpm         r8,          z         \n\t"
+        "mov         r30,         r7        \n\t"
+        "lpm         r9,          z         \n\t"
+        "mov         r30,         r4        \n\t"
+        "lpm         r6,          z         \n\t"
+        "mov         r30,         r5        \n\t"
+        "lpm         r7,          z         \n\t"
+        // AddConstants and AddRoundTweakey, the round keys are loaded once
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "movw        r30,         r28       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r14,         r22       \n\t"
+        "eor         r6,          r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r15,         r22       \n\t"
+        "eor         r7,          r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r16,         r22       \n\t"
+        "eor         r8,          r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r17,         r22       \n\t"
+        "eor         r9,          r22       \n\t"
+        "eor         r18,         r25       \n\t"
+        "eor         r10,         r25       \n\t"
+        "movw        r28,         r30       \n\t"
+        #else
+        "ld          r22,         y+        \n\t"
+        "eor         r14,         r22       \n\t"
+        "eor         r6,          r22       \n\t"
+        "ld          r22,         y+        \n\t"
+        "eor         r15,         r22       \n\t"
+        "eor         r7,          r22       \n\t"
+        "ld          r22,         y+        \n\t"
+        "eor         r16,         r22       \n\t"
+        "eor         r8,          r22       \n\t"
+        "ld          r22,         y+        \n\t"
+        "eor         r17,         r22       \n\t"
+        "eor         r9,          r22       \n\t"
+        "eor         r18,         r25       \n\t"
+        "eor         r10,         r25       \n\t"
+        #endif
+        // ShiftRows, but the third line is unchanged
+        "swap        r16                    \n\t"
+        "swap        r17                    \n\t"
+        "mov         r22,         r16       \n\t"
+        "eor         r22,         r17       \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         r16,         r22       \n\t"
+        "eor         r17,         r22       \n\t"
+        "swap        r20                    \n\t"
+        "swap        r21                    \n\t"
+        "mov         r22,         r20       \n\t"
+        "eor         r22,         r21       \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         r20,         r22       \n\t"
+        "eor         r21,         r22       \n\t"
+        "swap        r8                     \n\t"
+        "swap        r9                     \n\t"
+        "mov         r22,         r8        \n\t"
+        "eor         r22,         r9        \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         r8,          r22       \n\t"
+        "eor         r9,          r22       \n\t"
+        "swap        r12                    \n\t"
+        "swap        r13                    \n\t"
+        "mov         r22,         r12       \n\t"
+        "eor         r22,         r13       \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         r12,         r22       \n\t"
+        "eor         r13,         r22       \n\t"
+        // MixColumns
+        "eor         r16,         r19       \n\t"
+        "eor         r19,         r14       \n\t"
+        "eor         r20,         r19       \n\t"
+        "eor         r17,         r18       \n\t"
+        "eor         r18,         r15       \n\t"
+        "eor         r21,         r18       \n\t"
+        "eor         r8,          r11       \n\t"
+        "eor         r11,         r6        \n\t"
+        "eor         r12,         r11       \n\t"
+        "eor         r9,          r10       \n\t"
+        "eor         r10,         r7        \n\t"
+        "eor         r13,         r10       \n\t"
+        ".endr                  \n\t"
+    #if UNROLL_FACTOR < 36
+    "dec             r24                    \n\t"
+    "breq            enc2_exit              \n\t"
+    "rjmp            enc2_loop              \n\t"
+    "enc2_exit:                             \n\t"
+    #endif
+        // Store cipher text
+        "st          x,           r10       \n\t"
+        "st          -x,          r11       \n\t"
+        "st          -x,          r9        \n\t"
+        "st          -x,          r8        \n\t"
+        "st          -x,          r7        \n\t"
+        "st          -x,          r6        \n\t"
+        "st          -x,          r13       \n\t"
+        "st          -x,          r12       \n\t"
+        "st          -x,          r18       \n\t"
+        "st          -x,          r19       \n\t"
+        "st          -x,          r17       \n\t"
+        "st          -x,          r16       \n\t"
+        "st          -x,          r15       \n\t"
+        "st          -x,          r14       \n\t"
+        "st          -x,          r21       \n\t"
+        "st          -x,          r20       \n\t"
+        "pop         r29        \n\t"
+        "pop         r28        \n\t"
+        "pop         r17        \n\t"
+        "pop         r16        \n\t"
+        "pop         r15        \n\t"
+        "pop         r14        \n\t"
+        "pop         r13        \n\t"
+        "pop         r12        \n\t"
+        "pop         r11        \n\t"
+        "pop         r10        \n\t"
+        "pop         r9         \n\t"
+        "pop         r8         \n\t"
+        "pop         r7         \n\t"
+        "pop         r6         \n\t"
+        "pop         r5         \n\t"
+        "pop         r4         \n\t"
+    :
+    : [block] "x" (block), [roundKeys] "" (roundKeys), [SBOX] "" (SBOX));
+}
+
+/*
+ * Runs nRounds rounds (1 to 255) and returns, so that one block can be
+ * encrypted over several calls. ctx holds the 8-byte state followed by
+ * the roundKeys pointer of the next round; both are updated. On MSP
+ * ctx is accessed as words and must be 2-byte aligned.
+ */
+void EncryptStep(uint8_t *ctx, uint8_t nRounds)
+{
+    /*--------------------------------------*/
+    /* r14-r21  : state                     */
+    /* r22-r23  : temp use                  */
+    /* r24      : loop control              */
+    /* r25      : const 0x02                */
+    /* r26-r27  : X points to ctx           */
+    /* r28-r29  : Y points to roundKeys     */
+    /* r30-r31  : Z points to SBOX          */
+    /* -------------------------------------*/
+    asm volatile(
+        "push        r14        \n\t"
+        "push        r15        \n\t"
+        "push        r16        \n\t"
+        "push        r17        \n\t"
+        "push        r28        \n\t"
+        "push        r29        \n\t"
+        "mov         r24,         r22       \n\t"
+        // Load state and roundKeys pointer
+        "ld          r20,         x+        \n\t"
+        "ld          r21,         x+        \n\t"
+        "ld          r14,         x+        \n\t"
+        "ld          r15,         x+        \n\t"
+        "ld          r16,         x+        \n\t"
+        "ld          r17,         x+        \n\t"
+        "ld          r19,         x+        \n\t"
+        "ld          r18,         x+        \n\t"
+        "ld          r28,         x+        \n\t"
+        "ld          r29,         x         \n\t"
+        // used for constant 0x02
+        "ldi         r25,         0x20      \n\t"
+        "ldi         r31,         hi8(SBOX) \n\t"
+        // encryption
+    "step_loop:                             \n\t"
+        // SubCells
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "ldi         r31,         hi8(SBOX) \n\t"
+        #endif
+        "movw        r22,         r20       \n\t"
+        "mov         r30,         r19       \n\t"
+        "lpm         r20,         z         \n\t"
+        "mov         r30,         r18       \n\t"
+        "lpm         r21,         z         \n\t"
+        "mov         r30,         r16       \n\t"
+        "lpm         r18,         z         \n\t"
+        "mov         r30,         r17       \n\t"
+        "lpm         r19,         z         \n\t"
+        "mov         r30,         r14       \n\t"
+        "lpm         r16,         z         \n\t"
+        "mov         r30,         r15       \n\t"
+        "lpm         r17,         z         \n\t"
+        "mov         r30,         r22       \n\t"
+        "lpm         r14,         z         \n\t"
+        "mov         r30,         r23       \n\t"
+        "lpm         r15,         z         \n\t"
+        // AddConstants and AddRoundTweakey
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "movw        r30,         r28       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r14,         r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r15,         r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r16,         r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r17,         r22       \n\t"
+        "eor         r18,         r25       \n\t"
+        "movw        r28,         r30       \n\t"
+        #else
+        "ld          r22,         y+        \n\t"
+        "eor         r14,         r22       \n\t"
+        "ld          r22,         y+        \n\t"
+        "eor         r15,         r22       \n\t"
+        "ld          r22,         y+        \n\t"
+        "eor         r16,         r22       \n\t"
+        "ld          r22,         y+        \n\t"
+        "eor         r17,         r22       \n\t"
+        "eor         r18,         r25       \n\t"
+        #endif
+        // ShiftRows, but the third line is unchanged
+        "swap        r16                    \n\t"
+        "swap        r17                    \n\t"
+        "mov         r22,         r16       \n\t"
+        "eor         r22,         r17       \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         r16,         r22       \n\t"
+        "eor         r17,         r22       \n\t"
+        "swap        r20                    \n\t"
+        "swap        r21                    \n\t"
+        "mov         r22,         r20       \n\t"
+        "eor         r22,         r21       \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         r20,         r22       \n\t"
+        "eor         r21,         r22       \n\t"
+        // MixColumns
+        "eor         r16,         r19       \n\t"
+        "eor         r19,         r14       \n\t"
+        "eor         r20,         r19       \n\t"
+        "eor         r17,         r18       \n\t"
+        "eor         r18,         r15       \n\t"
+        "eor         r21,         r18       \n\t"
+    "dec             r24                    \n\t"
+    "brne            step_loop              \n\t"
+        // Store state and roundKeys pointer
+        "st          x,           r29       \n\t"
+        "st          -x,          r28       \n\t"
+        "st          -x,          r18       \n\t"
+        "st          -x,          r19       \n\t"
+        "st          -x,          r17       \n\t"
+        "st          -x,          r16       \n\t"
+        "st          -x,          r15       \n\t"
+        "st          -x,          r14       \n\t"
+        "st          -x,          r21       \n\t"
+        "st          -x,          r20       \n\t"
+        "pop         r29        \n\t"
+        "pop         r28        \n\t"
+        "pop         r17        \n\t"
+        "pop         r16        \n\t"
+        "pop         r15        \n\t"
+        "pop         r14        \n\t"
+    :
+    : [ctx] "x" (ctx), [nRounds] "" (nRounds), [SBOX] "" (SBOX));
+}
+
 #elif defined MSP
 void Encrypt(uint8_t *block, uint8_t *roundKeys)
 {
@@ -183,18 +660,24 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
     /* r14     : point to round keys         */
     /* r15     : point to block              */
     asm volatile(
+        #if defined(__MSP430X__)
+        "pushm       #4,        r7         \n\t"
+        "pushm       #2,        r11        \n\t"
+        #else
         "push        r4         \n\t"
         "push        r5         \n\t"
         "push        r6         \n\t"
         "push        r7         \n\t"
         "push        r10        \n\t"
         "push        r11        \n\t"
-        "mov         #36,       r13          \n\t"
+        #endif
+        "mov         #36/" STR(UNROLL_FACTOR) ",       r13          \n\t"
         "mov         0(r15),    r4           \n\t"
         "mov         2(r15),    r5           \n\t"
         "mov         4(r15),    r6           \n\t"
         "mov         6(r15),    r7           \n\t"
     "enc_loop:                               \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // SubCells, AddConstants, AddRoundTweakey
         "mov.b       r4,        r12          \n\t" 
         "mov.b       SBOX(r12), r11          \n\t"
@@ -250,22 +733,137 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "xor         r7,        r6           \n\t"
         "xor         r5,        r7           \n\t"
         "xor         r7,        r4           \n\t"
+        ".endr                  \n\t"
     "dec             r13                     \n\t"
+    #if UNROLL_FACTOR > 1
+    "jeq             enc_exit                \n\t"
+    "br              #enc_loop               \n\t"
+    "enc_exit:                               \n\t"
+    #else
     "jne             enc_loop                \n\t"
+    #endif
         "mov         r4,        0(r15)       \n\t"
         "mov         r5,        2(r15)       \n\t"
         "mov         r6,        4(r15)       \n\t"
         "mov         r7,        6(r15)       \n\t"
+        #if defined(__MSP430X__)
+        "popm        #2,        r11        \n\t"
+        "popm        #4,        r7         \n\t"
+        #else
         "pop         r11        \n\t"
         "pop         r10        \n\t"
         "pop         r7         \n\t"
         "pop         r6         \n\t"
         "pop         r5         \n\t"
         "pop         r4         \n\t"
+        #endif
     :
     : [block] "m" (block), [roundKeys] "m" (roundKeys), [SBOX] "" (SBOX));
 }
 
+void EncryptStep(uint8_t *ctx, uint8_t nRounds)
+{
+    /* r4-r7   : cipher state                */
+    /* r10-r12 : temp use                    */
+    /* r13     : currentRound                */
+    /* r14     : point to round keys         */
+    /* r15     : point to ctx                */
+    asm volatile(
+        #if defined(__MSP430X__)
+        "pushm       #4,        r7         \n\t"
+        "pushm       #2,        r11        \n\t"
+        #else
+        "push        r4         \n\t"
+        "push        r5         \n\t"
+        "push        r6         \n\t"
+        "push        r7         \n\t"
+        "push        r10        \n\t"
+        "push        r11        \n\t"
+        #endif
+        "mov.b       r14,       r13          \n\t"
+        "mov         8(r15),   r14          \n\t"
+        "mov         0(r15),    r4           \n\t"
+        "mov         2(r15),    r5           \n\t"
+        "mov         4(r15),    r6           \n\t"
+        "mov         6(r15),    r7           \n\t"
+    "step_loop:                              \n\t"
+        // SubCells, AddConstants, AddRoundTweakey
+        "mov.b       r4,        r12          \n\t" 
+        "mov.b       SBOX(r12), r11          \n\t"
+        "swpb        r4                      \n\t"
+        "mov.b       r4,        r12          \n\t"
+        "mov.b       SBOX(r12), r10          \n\t"
+        "swpb        r10                     \n\t"
+        "xor         r11,       r10          \n\t"
+        "xor         @r14+,     r10          \n\t"
+        "mov.b       r7,        r12          \n\t" // first line
+        "mov.b       SBOX(r12), r11          \n\t"
+        "swpb        r7                      \n\t"
+        "mov.b       r7,        r12          \n\t"
+        "mov.b       SBOX(r12), r4           \n\t"
+        "swpb        r4                      \n\t"
+        "xor         r11,       r4           \n\t"
+        "mov.b       r6,        r12          \n\t" // fourth line
+        "mov.b       SBOX(r12), r11          \n\t"
+        "swpb        r6                      \n\t"
+        "mov.b       r6,        r12          \n\t"
+        "mov.b       SBOX(r12), r7           \n\t"
+        "swpb        r7                      \n\t"
+        "xor         r11,       r7           \n\t"
+        "xor         #0x20,     r7           \n\t"
+        "mov.b       r5,        r12          \n\t" // third line
+        "mov.b       SBOX(r12), r11          \n\t"
+        "swpb        r5                      \n\t"
+        "mov.b       r5,        r12          \n\t"
+        "mov.b       SBOX(r12), r6           \n\t"
+        "swpb        r6                      \n\t"
+        "xor         r11,       r6           \n\t"
+        "xor         @r14+,     r6           \n\t"
+        "mov         r10,       r5           \n\t" // second line 
+        // ShiftRows
+        "bit         #1,        r6           \n\t"
+        "rrc         r6                      \n\t"
+        "bit         #1,        r6           \n\t"
+        "rrc         r6                      \n\t"
+        "bit         #1,        r6           \n\t"
+        "rrc         r6                      \n\t"
+        "bit         #1,        r6           \n\t"
+        "rrc         r6                      \n\t"
+        "swpb        r7                      \n\t"
+        "rla         r4                      \n\t"
+        "adc         r4                      \n\t"
+        "rla         r4                      \n\t"
+        "adc         r4                      \n\t"
+        "rla         r4                      \n\t"
+        "adc         r4                      \n\t"
+        "rla         r4                      \n\t"
+        "adc         r4                      \n\t"
+        // MixColumns
+        "xor         r7,        r6           \n\t"
+        "xor         r5,        r7           \n\t"
+        "xor         r7,        r4           \n\t"
+    "dec             r13                     \n\t"
+    "jne             step_loop               \n\t"
+        "mov         r4,        0(r15)       \n\t"
+        "mov         r5,        2(r15)       \n\t"
+        "mov         r6,        4(r15)       \n\t"
+        "mov         r7,        6(r15)       \n\t"
+        "mov         r14,       8(r15)       \n\t"
+        #if defined(__MSP430X__)
+        "popm        #2,        r11        \n\t"
+        "popm        #4,        r7         \n\t"
+        #else
+        "pop         r11        \n\t"
+        "pop         r10        \n\t"
+        "pop         r7         \n\t"
+        "pop         r6         \n\t"
+        "pop         r5         \n\t"
+        "pop         r4         \n\t"
+        #endif
+    :
+    : [ctx] "m" (ctx), [nRounds] "m" (nRounds), [SBOX] "" (SBOX));
+}
+
 #elif defined ARM
 void Encrypt(uint8_t *block, uint8_t *roundKeys)
 {
@@ -278,13 +876,15 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
     // r10   : 0xff
     asm volatile(
         "stmdb      sp!,      {r2-r10}         \n\t"
-        "mov        r8,       #36              \n\t"
-        "ldr        r9,       =SBOX            \n\t"
+        "mov        r8,       #36/" STR(UNROLL_FACTOR) "              \n\t"
+        "movw       r9,       #:lower16:SBOX           \n\t"
+        "movt       r9,       #:upper16:SBOX           \n\t"
         "mov        r10,      #0xff            \n\t"
         "ldrd       r2, r4,   [r0, #0]         \n\t"
         "mov        r3,       r2, lsr #16      \n\t"
         "mov        r5,       r4, lsr #16      \n\t"
     "enc_loop:                                 \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
         // SubCells
         // r2 (--  --  --  --  s2  s3  s0  s1)
         // r3 (--  --  --  --  s6  s7  s4  s5)
@@ -331,6 +931,7 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
         "eors       r4,       r4, r5           \n\t"
         "eors       r5,       r5, r3           \n\t"
         "eors       r2,       r2, r5           \n\t"
+        ".endr                  \n\t"
     "subs           r8,       r8, #1           \n\t"
     "bne            enc_loop                   \n\t"
         "bfi        r2, r3,   #16, #16         \n\t"
@@ -342,9 +943,82 @@ void Encrypt(uint8_t *block, uint8_t *roundKeys)
 }
 
 #else
+/*
+ * Portable version for hosts without SIMD. The block is one 64-bit
+ * word with s0 in the top nibble, so row i is the 16-bit lane at bit
+ * 48 - 16*i. SBOX is evaluated on the 16 nibbles at once with the
+ * NOR/XOR circuit of the specification, without a table lookup.
+ */
+static inline uint64_t sbox_mix(uint64_t x)
+{
+    return x ^ (~((x >> 3) | (x >> 2)) & 0x1111111111111111ULL);
+}
+
+static inline uint64_t SubCells(uint64_t x)
+{
+    // x0 ^= ~(x3 | x2), then rotate each nibble left by one bit
+    x = sbox_mix(x);
+    x = ((x << 1) & 0xeeeeeeeeeeeeeeeeULL) | ((x >> 3) & 0x1111111111111111ULL);
+    x = sbox_mix(x);
+    x = ((x << 1) & 0xeeeeeeeeeeeeeeeeULL) | ((x >> 3) & 0x1111111111111111ULL);
+    x = sbox_mix(x);
+    x = ((x << 1) & 0xeeeeeeeeeeeeeeeeULL) | ((x >> 3) & 0x1111111111111111ULL);
+    return sbox_mix(x);
+}
+
+static inline uint64_t ShiftRows(uint64_t x)
+{
+    // row i is rotated right by 4*i bits
+    return (x & 0xffff000000000000ULL) |
+           ((x >> 4) & 0x00000fff00000000ULL) |
+           ((x << 12) & 0x0000f00000000000ULL) |
+           ((x >> 8) & 0x0000000000ff0000ULL) |
+           ((x << 8) & 0x00000000ff000000ULL) |
+           ((x << 4) & 0x000000000000fff0ULL) |
+           ((x >> 12) & 0x000000000000000fULL);
+}
+
+static inline uint64_t MixColumns(uint64_t x)
+{
+    uint16_t r0 = x >> 48, r1 = x >> 32, r2 = x >> 16, r3 = x;
+
+    r1 ^= r2;
+    r2 ^= r0;
+    r3 ^= r2;
+    return ((uint64_t)r3 << 48) | ((uint64_t)r0 << 32) | ((uint64_t)r1 << 16) | r2;
+}
+
 void Encrypt(uint8_t *block, uint8_t *roundKeys)
 {
-    /* Add here the cipher encryption implementation */
+    uint64_t s = 0;
+    uint32_t k;
+    uint8_t i;
+
+    for (i = 0; i < 8; i++)
+    {
+        s = (s << 8) | block[i];
+    }
+    for (i = 0; i < 36; i++)
+    {
+        k = ((uint32_t)roundKeys[4 * i] << 24) | ((uint32_t)roundKeys[4 * i + 1] << 16) |
+            ((uint32_t)roundKeys[4 * i + 2] << 8) | roundKeys[4 * i + 3];
+        s = SubCells(s) ^ ((uint64_t)k << 32) ^ 0x20000000;
+        s = ShiftRows(s);
+        s = MixColumns(s);
+    }
+    for (i = 8; i > 0; i--)
+    {
+        block[i - 1] = s;
+        s >>= 8;
+    }
 }
 
 #endif
+
+#ifndef AVR
+void Encrypt2(uint8_t *block, uint8_t *roundKeys)
+{
+    Encrypt(block, roundKeys);
+    Encrypt(block + 8, roundKeys);
+}
+#endif
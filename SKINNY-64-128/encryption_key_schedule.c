@@ -243,8 +243,7 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
 void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
 {
     /* r4-r11  : key state                   */
-    /* r12     : temp use                    */
-    /* r13     : currentRound                */
+    /* r12-r13 : temp use                    */
     /* r14     : point to roundKeys          */
     /* r15     : point to key and RC         */
     asm volatile (
@@ -254,6 +253,9 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
          *     the first is passed in R15 and the second is passed in R14.
          * [r11-r4]:  r11-r4 must be pushed if used.
          */
+        #if defined(__MSP430X__)
+        "pushm        #8,           r11           \n\t"
+        #else
         "push         r4            \n\t"
         "push         r5            \n\t"
         "push         r6            \n\t"
@@ -262,6 +264,7 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "push         r9            \n\t"
         "push         r10           \n\t"
         "push         r11           \n\t"
+        #endif
         // Load master keys
         "mov          @r15+,        r4            \n\t"
         "mov          @r15+,        r5            \n\t"
@@ -271,18 +274,19 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "mov          @r15+,        r9            \n\t"
         "mov          @r15+,        r10           \n\t"
         "mov          @r15+,        r11           \n\t"
-        // Leave the memory for temp use
-        "sub          #2,           r1            \n\t"
         "mov          %[RC],        r15           \n\t"
-        "mov          #36,          r13           \n\t"
     "extend_loop:                                 \n\t"
         // AddRoundConstant
         "mov.b        @r15,         r12           \n\t"
         "and          #0x000f,      r12           \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #4,           r12           \n\t"
+        #else
         "rla          r12                         \n\t"
         "rla          r12                         \n\t"
         "rla          r12                         \n\t"
         "rla          r12                         \n\t"
+        #endif
         "xor          r4,           r12           \n\t"
         "xor          r8,           r12           \n\t"
         "mov          r12,          0(r14)        \n\t"
@@ -297,7 +301,6 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         // r5 (k6  k7  k4  k5)          r5 (k12 k11 k10 k14)
         // r6 (k10 k11 k8  k9)   -----> r6 (k2  k3  k0  k1)
         // r7 (k14 k15 k12 k13)         r7 (k6  k7  k4  k5)
-        "mov          r13,          0(r1)         \n\t"
         // Tweakey 1 -- First row
         "mov          r6,           r12           \n\t"
         "mov          r4,           r6            \n\t"
@@ -307,10 +310,14 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "mov          r4,           r13           \n\t"
         "and          #0x0f0f,      r4            \n\t"
         "mov          r12,          r5            \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #4,           r5            \n\t"
+        #else
         "rla          r5                          \n\t"
         "rla          r5                          \n\t"
         "rla          r5                          \n\t"
         "rla          r5                          \n\t"
+        #endif
         "and          #0xf0,        r5            \n\t"
         "xor          r5,           r4            \n\t"
         "mov          r12,          r5            \n\t"
@@ -324,10 +331,14 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "and          #0xf0,        r12           \n\t"
         "xor          r12,          r5            \n\t"
         "mov          r13,          r12           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #4,           r12           \n\t"
+        #else
         "rra          r12                         \n\t"
         "rra          r12                         \n\t"
         "rra          r12                         \n\t"
         "rra          r12                         \n\t"
+        #endif
         "and          #0xf,         r12           \n\t"
         "xor          r12,          r5            \n\t"
         "and          #0xf000,      r13           \n\t"
@@ -341,10 +352,14 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "mov          r8,           r13           \n\t"
         "and          #0x0f0f,      r8            \n\t"
         "mov          r12,          r9            \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #4,           r9            \n\t"
+        #else
         "rla          r9                          \n\t"
         "rla          r9                          \n\t"
         "rla          r9                          \n\t"
         "rla          r9                          \n\t"
+        #endif
         "and          #0xf0,        r9            \n\t"
         "xor          r9,           r8            \n\t"
         "mov          r12,          r9            \n\t"
@@ -358,10 +373,14 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "and          #0xf0,        r12           \n\t"
         "xor          r12,          r9            \n\t"
         "mov          r13,          r12           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #4,           r12           \n\t"
+        #else
         "rra          r12                         \n\t"
         "rra          r12                         \n\t"
         "rra          r12                         \n\t"
         "rra          r12                         \n\t"
+        #endif
         "and          #0xf,         r12           \n\t"
         "xor          r12,          r9            \n\t"
         "and          #0xf000,      r13           \n\t"
@@ -371,8 +390,12 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "mov          r8,           r13           \n\t"
         "rra          r13                         \n\t"
         "xor          r12,          r13           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #2,           r13           \n\t"
+        #else
         "rra          r13                         \n\t"
         "rra          r13                         \n\t"
+        #endif
         "and          #0x1111,      r13           \n\t"
         "rla          r8                          \n\t"
         "and          #0xeeee,      r8            \n\t"
@@ -382,18 +405,23 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "mov          r9,           r13           \n\t"
         "rra          r13                         \n\t"
         "xor          r12,          r13           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #2,           r13           \n\t"
+        #else
         "rra          r13                         \n\t"
         "rra          r13                         \n\t"
+        #endif
         "and          #0x1111,      r13           \n\t"
         "rla          r9                          \n\t"
         "and          #0xeeee,      r9            \n\t"
         "xor          r13,          r9            \n\t"
-        // Loop control
-        "mov          0(r1),        r13           \n\t"
-    "dec              r13                         \n\t"
+        // Loop control, stop after the last round constant
+        "cmp          #RC+36,       r15           \n\t"
     "jne              extend_loop                 \n\t"
-        "add          #2,           r1            \n\t"
         /* ----------------------------------------- */
+        #if defined(__MSP430X__)
+        "popm         #8,           r11           \n\t"
+        #else
         "pop          r11           \n\t"
         "pop          r10           \n\t"
         "pop          r9            \n\t"
@@ -402,6 +430,7 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
         "pop          r6            \n\t"
         "pop          r5            \n\t"
         "pop          r4            \n\t"    
+        #endif
     :
     : [key] "m" (key), [roundKeys] "m" (roundKeys), [RC] "" (RC));
 }
@@ -484,9 +513,113 @@ void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
 }
 
 #else
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+
+/*
+ * One cell per byte, so PT is a single pshufb. The LFSRs only act on
+ * the first two rows (the low 8 bytes).
+ */
+static inline __m128i LoadCells(uint8_t *key)
+{
+    __m128i x = _mm_loadl_epi64((__m128i *)key);
+    __m128i m = _mm_set1_epi8(0x0f);
+
+    return _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(x, 4), m), _mm_and_si128(x, m));
+}
+
+static inline __m128i LFSR2(__m128i x)
+{
+    __m128i y = _mm_and_si128(_mm_add_epi8(x, x), _mm_set1_epi8(0x0e));
+
+    y = _mm_or_si128(y, _mm_and_si128(_mm_xor_si128(_mm_srli_epi16(x, 3), _mm_srli_epi16(x, 2)),
+                                      _mm_set1_epi8(0x01)));
+    return _mm_or_si128(_mm_and_si128(y, _mm_setr_epi32(-1, -1, 0, 0)),
+                        _mm_and_si128(x, _mm_setr_epi32(0, 0, -1, -1)));
+}
+
+// two rounds of cells (with c0 and c1) to 8 bytes in 16-bit lanes
+static inline __m128i PackCells(__m128i a, __m128i b, uint8_t rc0, uint8_t rc1)
+{
+    __m128i x = _mm_unpacklo_epi64(a, b);
+
+    x = _mm_xor_si128(x, _mm_setr_epi32(rc0 & 0x0f, (rc0 >> 4) & 0x03, rc1 & 0x0f, (rc1 >> 4) & 0x03));
+    return _mm_maddubs_epi16(x, _mm_set1_epi16(0x0110));
+}
+
 void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
 {
-    /* Add here the cipher encryption key schedule implementation */
+    const __m128i pt = _mm_setr_epi8(9, 15, 8, 13, 10, 14, 12, 11, 0, 1, 2, 3, 4, 5, 6, 7);
+    __m128i tk1 = LoadCells(key);
+    __m128i tk2 = LoadCells(key + 8);
+    __m128i t[4];
+    uint8_t i, j;
+
+    for (i = 0; i < 36; i += 4)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            t[j] = _mm_xor_si128(tk1, tk2);
+            tk1 = _mm_shuffle_epi8(tk1, pt);
+            tk2 = LFSR2(_mm_shuffle_epi8(tk2, pt));
+        }
+        _mm_storeu_si128((__m128i *)(roundKeys + 4 * i),
+                         _mm_packus_epi16(PackCells(t[0], t[1], RC[i], RC[i + 1]),
+                                          PackCells(t[2], t[3], RC[i + 2], RC[i + 3])));
+    }
+}
+
+#else
+static void PermuteTweakey(uint8_t *tk)
+{
+    static const uint8_t PT[16] = {9, 15, 8, 13, 10, 14, 12, 11, 0, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t tmp[16];
+    uint8_t j;
+
+    for (j = 0; j < 16; j++)
+    {
+        tmp[j] = tk[PT[j]];
+    }
+    for (j = 0; j < 16; j++)
+    {
+        tk[j] = tmp[j];
+    }
+}
+
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    /*
+     * Same layout as the assembly versions: the first two rows of
+     * TK1 ^ TK2 (two cells per byte) with c0 and c1 added, 4 bytes
+     * per round.
+     */
+    uint8_t tk1[16], tk2[16];
+    uint8_t i, j;
+
+    for (j = 0; j < 8; j++)
+    {
+        tk1[2 * j] = key[j] >> 4;
+        tk1[2 * j + 1] = key[j] & 0x0f;
+        tk2[2 * j] = key[j + 8] >> 4;
+        tk2[2 * j + 1] = key[j + 8] & 0x0f;
+    }
+    for (i = 0; i < 36; i++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            roundKeys[4 * i + j] = ((tk1[2 * j] ^ tk2[2 * j]) << 4) | (tk1[2 * j + 1] ^ tk2[2 * j + 1]);
+        }
+        roundKeys[4 * i + 0] ^= (RC[i] & 0x0f) << 4;
+        roundKeys[4 * i + 2] ^= RC[i] & 0x30;
+        PermuteTweakey(tk1);
+        PermuteTweakey(tk2);
+        // LFSR of TK2 on the first two rows
+        for (j = 0; j < 8; j++)
+        {
+            tk2[j] = ((tk2[j] << 1) & 0x0e) | (((tk2[j] >> 3) ^ (tk2[j] >> 2)) & 0x01);
+        }
+    }
 }
 
-#endif
\ No newline at end of file
+#endif
+#endif
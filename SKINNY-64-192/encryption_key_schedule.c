@@ -0,0 +1,859 @@
+/*
+ * SKINNY-64-192
+ * @Time 2017
+ * @Author luopeng(luopeng@iie.ac.cn)
+ */
+
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * FELICS - Fair Evaluation of Lightweight Cryptographic Systems
+ *
+ * Copyright (C) 2015 University of Luxembourg
+ *
+ * Written in 2015 by Daniel Dinu <dumitru-daniel.dinu@uni.lu>
+ *
+ * This file is part of FELICS.
+ *
+ * FELICS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FELICS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+#include "cipher.h"
+#include "constants.h"
+
+#ifdef AVR
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    /*--------------------------------------*/
+    // Round keys and round constants are eor-ed
+    // and stored together
+    /* r5      : 0x0f                       */
+    /* r6,r7,r24,r25 : temp                 */
+    /* r8-r23  : master keys, TK3 in r16-r23 */
+    /*           in the second pass         */
+    /* r26     : loop control               */
+    /* r27     : 0xf0                       */
+    /* r26-r27 : X points to master keys    */
+    /* r28-r29 : Y points to roundKeys      */
+    /* r30-r31 : Z points to RC             */
+    /* -------------------------------------*/
+    asm volatile(
+    	"push         r5         \n\t"
+        "push         r6         \n\t"
+        "push         r7         \n\t"
+        "push         r8         \n\t"
+        "push         r9         \n\t"
+        "push         r10        \n\t"
+        "push         r11        \n\t"
+        "push         r12        \n\t"
+        "push         r13        \n\t"
+        "push         r14        \n\t"
+        "push         r15        \n\t"
+        "push         r16        \n\t"
+        "push         r17        \n\t"
+        "push         r28        \n\t"
+        "push         r29        \n\t"
+        "movw         r26,        r24       \n\t"
+        "movw         r28,        r22       \n\t"
+        // Load keys
+        // Tweak1        Tweak2
+        // r8  r9        r16 r17
+        // r10 r11       r18 r19
+        // r12 r13       r20 r21
+        // r14 r15       r22 r23
+        // Tweak3 is loaded into r16-r23 by the second pass,
+        // keep its address.
+        "ld           r8,         x+        \n\t"
+        "ld           r9,         x+        \n\t"
+        "ld           r10,        x+        \n\t"
+        "ld           r11,        x+        \n\t"
+        "ld           r12,        x+        \n\t"
+        "ld           r13,        x+        \n\t"
+        "ld           r14,        x+        \n\t"
+        "ld           r15,        x+        \n\t"
+        "ld           r16,        x+        \n\t"
+        "ld           r17,        x+        \n\t"
+        "ld           r18,        x+        \n\t"
+        "ld           r19,        x+        \n\t"
+        "ld           r20,        x+        \n\t"
+        "ld           r21,        x+        \n\t"
+        "ld           r22,        x+        \n\t"
+        "ld           r23,        x+        \n\t"
+        "push         r26        \n\t"
+        "push         r27        \n\t"
+        // Init
+        "ldi          r26,        40        \n\t"
+        "ldi          r27,        0x0f      \n\t"
+        "mov          r5,         r27       \n\t"
+        "ldi          r27,        0xf0      \n\t"
+        "ldi          r30,        lo8(RC)   \n\t"
+        "ldi          r31,        hi8(RC)   \n\t"
+    "key_schedule_start:                    \n\t"
+        // XOR RoundConstant and the TweakKeys together
+        "lpm          r24,        z+        \n\t"
+        "mov          r25,        r24       \n\t"
+        "andi         r25,        0x0f      \n\t"
+        "swap         r25                   \n\t"
+        "mov          r6,         r8        \n\t" // store k0
+        "eor          r6,         r25       \n\t"
+        "eor          r6,         r16       \n\t"
+        "st           y+,         r6        \n\t"
+        "mov          r6,         r9        \n\t" // store k1
+        "eor          r6,         r17       \n\t"
+        "st           y+,         r6        \n\t"
+        "andi         r24,        0x30      \n\t" // store k2
+        "mov          r6,         r10       \n\t"
+        "eor          r6,         r24       \n\t"
+        "eor          r6,         r18       \n\t"
+        "st           y+,         r6        \n\t"
+        "mov          r6,         r11       \n\t" // store k3
+        "eor          r6,         r19       \n\t"
+        "st           y+,         r6        \n\t"        
+        // (k0  k1 ) (k2  k3 )        (k9  k15) (k8  k13)
+        // (k4  k5 ) (k6  k7 )        (k10 k14) (k12 k11)
+        // (k8  k9 ) (k10 k11) -----> (k0  k1 ) (k2  k3 )
+        // (k12 k13) (k14 k15)        (k4  k5 ) (k6  k7 )
+        // Tweakey 1
+        "movw         r6,         r12       \n\t"
+        "movw         r12,        r8        \n\t"
+        "movw         r8,         r14       \n\t"
+        "movw         r14,        r10       \n\t"
+        "mov          r11,        r7        \n\t"
+        "and          r11,        r5        \n\t"
+        "mov          r10,        r8        \n\t"
+        "and          r10,        r27       \n\t"
+        "eor          r11,        r10       \n\t"
+        "mov          r10,        r7        \n\t"
+        "and          r10,        r27       \n\t"
+        "mov          r7,         r9        \n\t"
+        "and          r7,         r27       \n\t"
+        "swap         r7                    \n\t"
+        "eor          r10,        r7        \n\t"
+        "mov          r7,         r8        \n\t"
+        "and          r7,         r5        \n\t"
+        "mov          r8,         r6        \n\t"
+        "and          r8,         r27       \n\t"
+        "eor          r7,         r8        \n\t"
+        "mov          r8,         r9        \n\t"
+        "and          r8,         r5        \n\t"
+        "swap         r6                    \n\t"
+        "and          r6,         r27       \n\t"
+        "eor          r8,         r6        \n\t"
+        "mov          r9,         r7        \n\t"
+        // Tweakey 2
+        "movw         r6,         r20       \n\t"
+        "movw         r20,        r16       \n\t"
+        "movw         r16,        r22       \n\t"
+        "movw         r22,        r18       \n\t"
+        "mov          r19,        r7        \n\t"
+        "and          r19,        r5        \n\t"
+        "mov          r18,        r16       \n\t"
+        "and          r18,        r27       \n\t"
+        "eor          r19,        r18       \n\t"
+        "mov          r18,        r7        \n\t"
+        "and          r18,        r27       \n\t"
+        "mov          r7,         r17       \n\t"
+        "and          r7,         r27       \n\t"
+        "swap         r7                    \n\t"
+        "eor          r18,        r7        \n\t"
+        "mov          r7,         r16       \n\t"
+        "and          r7,         r5        \n\t"
+        "mov          r16,        r6        \n\t"
+        "and          r16,        r27       \n\t"
+        "eor          r7,         r16       \n\t"
+        "mov          r16,        r17       \n\t"
+        "and          r16,        r5        \n\t"
+        "swap         r6                    \n\t"
+        "and          r6,         r27       \n\t"
+        "eor          r16,        r6        \n\t"
+        "mov          r17,        r7        \n\t"
+        // LFSR
+        "movw         r24,        r16       \n\t" // half of first row
+        "movw         r6,         r16       \n\t"
+        "lsr          r6                    \n\t"
+        "eor          r24,        r6        \n\t"
+        "lsr          r24                   \n\t"
+        "lsr          r24                   \n\t"
+        "andi         r24,        0x11      \n\t"
+        "lsl          r16                   \n\t"
+        "andi         r16,        0xee      \n\t"
+        "eor          r16,        r24       \n\t"
+        "lsr          r7                    \n\t" // the other half
+        "eor          r25,        r7        \n\t" // of first row
+        "lsr          r25                   \n\t"
+        "lsr          r25                   \n\t"
+        "andi         r25,        0x11      \n\t"
+        "lsl          r17                   \n\t"
+        "andi         r17,        0xee      \n\t"
+        "eor          r17,        r25       \n\t"
+        "movw         r24,        r18       \n\t" // half of second row
+        "movw         r6,         r18       \n\t"
+        "lsr          r6                    \n\t"
+        "eor          r24,        r6        \n\t"
+        "lsr          r24                   \n\t"
+        "lsr          r24                   \n\t"
+        "andi         r24,        0x11      \n\t"
+        "lsl          r18                   \n\t"
+        "andi         r18,        0xee      \n\t"
+        "eor          r18,        r24       \n\t"
+        "lsr          r7                    \n\t" // the other half
+        "eor          r25,        r7        \n\t" // of second row
+        "lsr          r25                   \n\t"
+        "lsr          r25                   \n\t"
+        "andi         r25,        0x11      \n\t"
+        "lsl          r19                   \n\t"
+        "andi         r19,        0xee      \n\t"
+        "eor          r19,        r25       \n\t"
+    "dec              r26                   \n\t"
+    "breq             key_schedule_exit     \n\t"
+    "rjmp             key_schedule_start    \n\t"
+    "key_schedule_exit:                     \n\t"
+        // Second pass, eor TweakKey 3 into the round keys
+        "pop          r27        \n\t"
+        "pop          r26        \n\t"
+        "ld           r16,        x+        \n\t"
+        "ld           r17,        x+        \n\t"
+        "ld           r18,        x+        \n\t"
+        "ld           r19,        x+        \n\t"
+        "ld           r20,        x+        \n\t"
+        "ld           r21,        x+        \n\t"
+        "ld           r22,        x+        \n\t"
+        "ld           r23,        x+        \n\t"
+        "subi         r28,        lo8(160)  \n\t"
+        "sbci         r29,        hi8(160)  \n\t"
+        "ldi          r26,        40        \n\t"
+        "ldi          r27,        0xf0      \n\t"
+    "key_schedule_tk3:                      \n\t"
+        "ld           r6,         y         \n\t" // k0
+        "eor          r6,         r16       \n\t"
+        "st           y+,         r6        \n\t"
+        "ld           r6,         y         \n\t" // k1
+        "eor          r6,         r17       \n\t"
+        "st           y+,         r6        \n\t"
+        "ld           r6,         y         \n\t" // k2
+        "eor          r6,         r18       \n\t"
+        "st           y+,         r6        \n\t"
+        "ld           r6,         y         \n\t" // k3
+        "eor          r6,         r19       \n\t"
+        "st           y+,         r6        \n\t"
+        // Tweakey 3
+        "movw         r6,         r20       \n\t"
+        "movw         r20,        r16       \n\t"
+        "movw         r16,        r22       \n\t"
+        "movw         r22,        r18       \n\t"
+        "mov          r19,        r7        \n\t"
+        "and          r19,        r5        \n\t"
+        "mov          r18,        r16       \n\t"
+        "and          r18,        r27       \n\t"
+        "eor          r19,        r18       \n\t"
+        "mov          r18,        r7        \n\t"
+        "and          r18,        r27       \n\t"
+        "mov          r7,         r17       \n\t"
+        "and          r7,         r27       \n\t"
+        "swap         r7                    \n\t"
+        "eor          r18,        r7        \n\t"
+        "mov          r7,         r16       \n\t"
+        "and          r7,         r5        \n\t"
+        "mov          r16,        r6        \n\t"
+        "and          r16,        r27       \n\t"
+        "eor          r7,         r16       \n\t"
+        "mov          r16,        r17       \n\t"
+        "and          r16,        r5        \n\t"
+        "swap         r6                    \n\t"
+        "and          r6,         r27       \n\t"
+        "eor          r16,        r6        \n\t"
+        "mov          r17,        r7        \n\t"
+        // LFSR
+        "mov          r24,        r16       \n\t"
+        "lsl          r24                   \n\t"
+        "lsl          r24                   \n\t"
+        "lsl          r24                   \n\t"
+        "eor          r24,        r16       \n\t"
+        "andi         r24,        0x88      \n\t"
+        "lsr          r16                   \n\t"
+        "andi         r16,        0x77      \n\t"
+        "eor          r16,        r24       \n\t"
+        "mov          r24,        r17       \n\t"
+        "lsl          r24                   \n\t"
+        "lsl          r24                   \n\t"
+        "lsl          r24                   \n\t"
+        "eor          r24,        r17       \n\t"
+        "andi         r24,        0x88      \n\t"
+        "lsr          r17                   \n\t"
+        "andi         r17,        0x77      \n\t"
+        "eor          r17,        r24       \n\t"
+        "mov          r24,        r18       \n\t"
+        "lsl          r24                   \n\t"
+        "lsl          r24                   \n\t"
+        "lsl          r24                   \n\t"
+        "eor          r24,        r18       \n\t"
+        "andi         r24,        0x88      \n\t"
+        "lsr          r18                   \n\t"
+        "andi         r18,        0x77      \n\t"
+        "eor          r18,        r24       \n\t"
+        "mov          r24,        r19       \n\t"
+        "lsl          r24                   \n\t"
+        "lsl          r24                   \n\t"
+        "lsl          r24                   \n\t"
+        "eor          r24,        r19       \n\t"
+        "andi         r24,        0x88      \n\t"
+        "lsr          r19                   \n\t"
+        "andi         r19,        0x77      \n\t"
+        "eor          r19,        r24       \n\t"
+    "dec              r26                   \n\t"
+    "breq             key_schedule_tk3_exit \n\t"
+    "rjmp             key_schedule_tk3      \n\t"
+    "key_schedule_tk3_exit:                 \n\t"
+        "pop          r29         \n\t"
+        "pop          r28         \n\t"
+        "pop          r17         \n\t"
+        "pop          r16         \n\t"
+        "pop          r15         \n\t"
+        "pop          r14         \n\t"
+        "pop          r13         \n\t"
+        "pop          r12         \n\t"
+        "pop          r11         \n\t"
+        "pop          r10         \n\t"
+        "pop          r9          \n\t"
+        "pop          r8          \n\t"
+        "pop          r7          \n\t"
+        "pop          r6          \n\t"
+        "pop          r5          \n\t"
+        :
+        : [key] "" (key), [roundKeys] "" (roundKeys), [RC] "" (RC));
+}
+
+#elif defined MSP
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    /* r4-r11  : key state, TK3 in r8-r11    */
+    /*           in the second pass          */
+    /* r12-r13 : temp use                    */
+    /* r14     : point to roundKeys          */
+    /* r15     : point to key and RC         */
+    asm volatile (
+        /*
+         * [r15-r12]: In MSPGCC, registers are passed starting with R15 and descending to R12.
+         *     For example, if two integers are passed,
+         *     the first is passed in R15 and the second is passed in R14.
+         * [r11-r4]:  r11-r4 must be pushed if used.
+         */
+        #if defined(__MSP430X__)
+        "pushm        #8,           r11           \n\t"
+        #else
+        "push         r4            \n\t"
+        "push         r5            \n\t"
+        "push         r6            \n\t"
+        "push         r7            \n\t"
+        "push         r8            \n\t"
+        "push         r9            \n\t"
+        "push         r10           \n\t"
+        "push         r11           \n\t"
+        #endif
+        // Load master keys
+        "mov          @r15+,        r4            \n\t"
+        "mov          @r15+,        r5            \n\t"
+        "mov          @r15+,        r6            \n\t"
+        "mov          @r15+,        r7            \n\t"
+        "mov          @r15+,        r8            \n\t"
+        "mov          @r15+,        r9            \n\t"
+        "mov          @r15+,        r10           \n\t"
+        "mov          @r15+,        r11           \n\t"
+        // Keep the address of TK3
+        "push         r15           \n\t"
+        "mov          %[RC],        r15           \n\t"
+    "extend_loop:                                 \n\t"
+        // AddRoundConstant
+        "mov.b        @r15,         r12           \n\t"
+        "and          #0x000f,      r12           \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #4,           r12           \n\t"
+        #else
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        #endif
+        "xor          r4,           r12           \n\t"
+        "xor          r8,           r12           \n\t"
+        "mov          r12,          0(r14)        \n\t"
+        "mov.b        @r15+,        r12           \n\t"
+        "and          #0x0030,      r12           \n\t"
+        "xor          r5,           r12           \n\t"
+        "xor          r9,           r12           \n\t"
+        "mov          r12,          2(r14)        \n\t"
+        "add          #4,           r14           \n\t"
+        // Permutation
+        // r4 (k2  k3  k0  k1)          r4 (k8 k13  k9  k15)
+        // r5 (k6  k7  k4  k5)          r5 (k12 k11 k10 k14)
+        // r6 (k10 k11 k8  k9)   -----> r6 (k2  k3  k0  k1)
+        // r7 (k14 k15 k12 k13)         r7 (k6  k7  k4  k5)
+        // Tweakey 1 -- First row
+        "mov          r6,           r12           \n\t"
+        "mov          r4,           r6            \n\t"
+        "mov          r7,           r4            \n\t"
+        "mov          r5,           r7            \n\t"
+        "swpb         r4                          \n\t"
+        "mov          r4,           r13           \n\t"
+        "and          #0x0f0f,      r4            \n\t"
+        "mov          r12,          r5            \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #4,           r5            \n\t"
+        #else
+        "rla          r5                          \n\t"
+        "rla          r5                          \n\t"
+        "rla          r5                          \n\t"
+        "rla          r5                          \n\t"
+        #endif
+        "and          #0xf0,        r5            \n\t"
+        "xor          r5,           r4            \n\t"
+        "mov          r12,          r5            \n\t"
+        "swpb         r5                          \n\t"
+        "and          #0xf000,      r5            \n\t"
+        "xor          r5,           r4            \n\t"
+        // Tweakey 1 -- Second row
+        "mov          r12,          r5            \n\t"
+        "and          #0x0f00,      r5            \n\t"
+        "swpb         r12                         \n\t"
+        "and          #0xf0,        r12           \n\t"
+        "xor          r12,          r5            \n\t"
+        "mov          r13,          r12           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #4,           r12           \n\t"
+        #else
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        #endif
+        "and          #0xf,         r12           \n\t"
+        "xor          r12,          r5            \n\t"
+        "and          #0xf000,      r13           \n\t"
+        "xor          r13,          r5            \n\t"
+        // Tweakey 2 -- First row
+        "mov          r10,          r12           \n\t"
+        "mov          r8,           r10           \n\t"
+        "mov          r11,          r8            \n\t"
+        "mov          r9,           r11           \n\t"
+        "swpb         r8                          \n\t"
+        "mov          r8,           r13           \n\t"
+        "and          #0x0f0f,      r8            \n\t"
+        "mov          r12,          r9            \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #4,           r9            \n\t"
+        #else
+        "rla          r9                          \n\t"
+        "rla          r9                          \n\t"
+        "rla          r9                          \n\t"
+        "rla          r9                          \n\t"
+        #endif
+        "and          #0xf0,        r9            \n\t"
+        "xor          r9,           r8            \n\t"
+        "mov          r12,          r9            \n\t"
+        "swpb         r9                          \n\t"
+        "and          #0xf000,      r9            \n\t"
+        "xor          r9,           r8            \n\t"
+        // Tweakey 2 -- Second row
+        "mov          r12,          r9            \n\t"
+        "and          #0x0f00,      r9            \n\t"
+        "swpb         r12                         \n\t"
+        "and          #0xf0,        r12           \n\t"
+        "xor          r12,          r9            \n\t"
+        "mov          r13,          r12           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #4,           r12           \n\t"
+        #else
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        #endif
+        "and          #0xf,         r12           \n\t"
+        "xor          r12,          r9            \n\t"
+        "and          #0xf000,      r13           \n\t"
+        "xor          r13,          r9            \n\t"
+        // LFSR -- Tweakey 2 First row
+        "mov          r8,           r12           \n\t"
+        "mov          r8,           r13           \n\t"
+        "rra          r13                         \n\t"
+        "xor          r12,          r13           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #2,           r13           \n\t"
+        #else
+        "rra          r13                         \n\t"
+        "rra          r13                         \n\t"
+        #endif
+        "and          #0x1111,      r13           \n\t"
+        "rla          r8                          \n\t"
+        "and          #0xeeee,      r8            \n\t"
+        "xor          r13,          r8            \n\t"
+        // LFSR -- Tweakey 2 Second row
+        "mov          r9,           r12           \n\t"
+        "mov          r9,           r13           \n\t"
+        "rra          r13                         \n\t"
+        "xor          r12,          r13           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #2,           r13           \n\t"
+        #else
+        "rra          r13                         \n\t"
+        "rra          r13                         \n\t"
+        #endif
+        "and          #0x1111,      r13           \n\t"
+        "rla          r9                          \n\t"
+        "and          #0xeeee,      r9            \n\t"
+        "xor          r13,          r9            \n\t"
+        // Loop control, stop after the last round constant
+        "cmp          #RC+40,       r15           \n\t"
+    "jne              extend_loop                 \n\t"
+        // Second pass, xor TweakKey 3 into the round keys
+        "pop          r15           \n\t"
+        "mov          @r15+,        r8            \n\t"
+        "mov          @r15+,        r9            \n\t"
+        "mov          @r15+,        r10           \n\t"
+        "mov          @r15+,        r11           \n\t"
+        "sub          #160,         r14           \n\t"
+        "mov          #40,          r15           \n\t"
+    "tk3_loop:                                    \n\t"
+        "xor          r8,           0(r14)        \n\t"
+        "xor          r9,           2(r14)        \n\t"
+        "add          #4,           r14           \n\t"
+        // Tweakey 3 -- First row
+        "mov          r10,          r12           \n\t"
+        "mov          r8,           r10           \n\t"
+        "mov          r11,          r8            \n\t"
+        "mov          r9,           r11           \n\t"
+        "swpb         r8                          \n\t"
+        "mov          r8,           r13           \n\t"
+        "and          #0x0f0f,      r8            \n\t"
+        "mov          r12,          r9            \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #4,           r9            \n\t"
+        #else
+        "rla          r9                          \n\t"
+        "rla          r9                          \n\t"
+        "rla          r9                          \n\t"
+        "rla          r9                          \n\t"
+        #endif
+        "and          #0xf0,        r9            \n\t"
+        "xor          r9,           r8            \n\t"
+        "mov          r12,          r9            \n\t"
+        "swpb         r9                          \n\t"
+        "and          #0xf000,      r9            \n\t"
+        "xor          r9,           r8            \n\t"
+        // Tweakey 3 -- Second row
+        "mov          r12,          r9            \n\t"
+        "and          #0x0f00,      r9            \n\t"
+        "swpb         r12                         \n\t"
+        "and          #0xf0,        r12           \n\t"
+        "xor          r12,          r9            \n\t"
+        "mov          r13,          r12           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #4,           r12           \n\t"
+        #else
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        #endif
+        "and          #0xf,         r12           \n\t"
+        "xor          r12,          r9            \n\t"
+        "and          #0xf000,      r13           \n\t"
+        "xor          r13,          r9            \n\t"
+        // LFSR -- Tweakey 3 First row
+        "mov          r8,           r12           \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #3,           r12           \n\t"
+        #else
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        #endif
+        "xor          r8,           r12           \n\t"
+        "and          #0x8888,      r12           \n\t"
+        "rra          r8                          \n\t"
+        "and          #0x7777,      r8            \n\t"
+        "xor          r12,          r8            \n\t"
+        // LFSR -- Tweakey 3 Second row
+        "mov          r9,           r12           \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #3,           r12           \n\t"
+        #else
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        #endif
+        "xor          r9,           r12           \n\t"
+        "and          #0x8888,      r12           \n\t"
+        "rra          r9                          \n\t"
+        "and          #0x7777,      r9            \n\t"
+        "xor          r12,          r9            \n\t"
+    "dec              r15                         \n\t"
+    "jne              tk3_loop                    \n\t"
+        /* ----------------------------------------- */
+        #if defined(__MSP430X__)
+        "popm         #8,           r11           \n\t"
+        #else
+        "pop          r11           \n\t"
+        "pop          r10           \n\t"
+        "pop          r9            \n\t"
+        "pop          r8            \n\t"
+        "pop          r7            \n\t"
+        "pop          r6            \n\t"
+        "pop          r5            \n\t"
+        "pop          r4            \n\t"    
+        #endif
+    :
+    : [key] "m" (key), [roundKeys] "m" (roundKeys), [RC] "" (RC));
+}
+
+#elif defined ARM
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    // r0    : ponits to key
+    // r1    : points to roundKeys
+    // r2-r5 : key state, TK3 in r4-r5 in the second pass
+    // r6-r7 : temp use
+    // r8    : loop control
+    // r9    : points to RC
+    // r10   : 0xf00f0
+    // r11   : 0xf00f0f
+    asm volatile(
+        "stmdb      sp!,      {r2-r11}        \n\t"
+        "mov        r8,       #40             \n\t"
+        "ldr        r9,       =RC             \n\t"
+        "mov        r10,      #0xf            \n\t"
+        "lsl        r10,      #16             \n\t"
+        "eors       r10,      r10, #0xf0      \n\t"
+        "mov        r11,      r10, lsl #4     \n\t"
+        "eors       r11,      r11, #0xf       \n\t"
+        "ldmia      r0,       {r2-r5}         \n\t" // load master key
+    "key_loop:                                \n\t"
+        "ldrb       r6,       [r9]            \n\t"
+        "adds       r9,       r9, #1          \n\t"
+        "mov        r7,       r6, lsl #16     \n\t"
+        "and        r6,       r6, #0xf        \n\t"
+        "eors       r6,       r2, r6, lsl #4  \n\t"
+        "and        r7,       r7, #0x300000  \n\t"
+        "eors       r6,       r6, r7         \n\t"
+        "eors       r6,       r6, r4          \n\t"
+        "str        r6,       [r1,#0]         \n\t" // store round keys
+        "adds       r1,       r1, #4          \n\t"
+        // Permutation
+        // Tweakey 1
+        // r2(k6  k7  k4  k5  k2  k3  k0  k1)    k12 k11 k10 k14 k8  k13 k9 k15
+        // r3(k14 k15 k12 k13 k10 k11 k8  k9) -> k6  k7  k4  k5  k2  k3  k0  k1
+        "mov        r6,       r3              \n\t" 
+        "mov        r3,       r2              \n\t"
+        "rev        r2,       r6              \n\t"
+        "ands       r2,       r2, r11         \n\t"
+        "mov        r7,       r6, lsl #8      \n\t"
+        "and        r7,       r7, #0xf000f000 \n\t"
+        "eors       r2,       r2, r7          \n\t"
+        "rev16      r7,       r6              \n\t"
+        "and        r7,       r10, r7, lsr #4 \n\t"
+        "eors       r2,       r2, r7          \n\t"
+        "and        r6,       r6, #0xf00      \n\t"
+        "eors       r2,       r2, r6, lsl #16 \n\t"
+        // Tweakey 2
+        "mov        r6,       r5              \n\t" 
+        "mov        r5,       r4              \n\t"
+        "rev        r4,       r6              \n\t"
+        "ands       r4,       r4, r11         \n\t"
+        "mov        r7,       r6, lsl #8      \n\t"
+        "and        r7,       r7, #0xf000f000 \n\t"
+        "eors       r4,       r4, r7          \n\t"
+        "rev16      r7,       r6              \n\t"
+        "and        r7,       r10, r7, lsr #4 \n\t"
+        "eors       r4,       r4, r7          \n\t"
+        "and        r6,       r6, #0xf00      \n\t"
+        "eors       r4,       r4, r6, lsl #16 \n\t"
+        // LFSR -- Tweakey 2
+        "mov        r6,       r4              \n\t"
+        "mov        r7,       r4              \n\t"
+        "eor        r6,       r6, r7, lsr #1  \n\t"
+        "lsr        r6,       #2              \n\t"
+        "and        r6,       r6, #0x11111111 \n\t"
+        "lsl        r4,       #1              \n\t"
+        "and        r4,       r4, #0xeeeeeeee \n\t"
+        "eors       r4,       r4, r6          \n\t"
+    "subs           r8,       r8, #1          \n\t"
+    "bne            key_loop                  \n\t"
+        // Second pass, eor TweakKey 3 into the round keys
+        "ldrd       r4, r5,   [r0, #16]       \n\t"
+        "subs       r1,       r1, #160        \n\t"
+        "mov        r8,       #40             \n\t"
+    "key_loop_tk3:                            \n\t"
+        "ldr        r6,       [r1,#0]         \n\t"
+        "eors       r6,       r6, r4          \n\t"
+        "str        r6,       [r1,#0]         \n\t"
+        "adds       r1,       r1, #4          \n\t"
+        // Tweakey 3
+        "mov        r6,       r5              \n\t" 
+        "mov        r5,       r4              \n\t"
+        "rev        r4,       r6              \n\t"
+        "ands       r4,       r4, r11         \n\t"
+        "mov        r7,       r6, lsl #8      \n\t"
+        "and        r7,       r7, #0xf000f000 \n\t"
+        "eors       r4,       r4, r7          \n\t"
+        "rev16      r7,       r6              \n\t"
+        "and        r7,       r10, r7, lsr #4 \n\t"
+        "eors       r4,       r4, r7          \n\t"
+        "and        r6,       r6, #0xf00      \n\t"
+        "eors       r4,       r4, r6, lsl #16 \n\t"
+        // LFSR -- Tweakey 3
+        "mov        r6,       r4, lsl #3      \n\t"
+        "eors       r6,       r6, r4          \n\t"
+        "and        r6,       r6, #0x88888888 \n\t"
+        "lsr        r4,       #1              \n\t"
+        "and        r4,       r4, #0x77777777 \n\t"
+        "eors       r4,       r4, r6          \n\t"
+    "subs           r8,       r8, #1          \n\t"
+    "bne            key_loop_tk3              \n\t"
+        "ldmia      sp!,      {r2-r11}        \n\t"
+    :
+    : [key] "r" (key), [roundKeys] "r" (roundKeys), [RC] "" (RC));
+}
+
+#else
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+
+/*
+ * One cell per byte, so PT is a single pshufb. The LFSRs only act on
+ * the first two rows (the low 8 bytes).
+ */
+static inline __m128i LoadCells(uint8_t *key)
+{
+    __m128i x = _mm_loadl_epi64((__m128i *)key);
+    __m128i m = _mm_set1_epi8(0x0f);
+
+    return _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(x, 4), m), _mm_and_si128(x, m));
+}
+
+static inline __m128i LFSR2(__m128i x)
+{
+    __m128i y = _mm_and_si128(_mm_add_epi8(x, x), _mm_set1_epi8(0x0e));
+
+    y = _mm_or_si128(y, _mm_and_si128(_mm_xor_si128(_mm_srli_epi16(x, 3), _mm_srli_epi16(x, 2)),
+                                      _mm_set1_epi8(0x01)));
+    return _mm_or_si128(_mm_and_si128(y, _mm_setr_epi32(-1, -1, 0, 0)),
+                        _mm_and_si128(x, _mm_setr_epi32(0, 0, -1, -1)));
+}
+
+static inline __m128i LFSR3(__m128i x)
+{
+    __m128i y = _mm_and_si128(_mm_srli_epi16(x, 1), _mm_set1_epi8(0x07));
+
+    y = _mm_or_si128(y, _mm_and_si128(_mm_xor_si128(_mm_slli_epi16(x, 3), x), _mm_set1_epi8(0x08)));
+    return _mm_or_si128(_mm_and_si128(y, _mm_setr_epi32(-1, -1, 0, 0)),
+                        _mm_and_si128(x, _mm_setr_epi32(0, 0, -1, -1)));
+}
+
+// two rounds of cells (with c0 and c1) to 8 bytes in 16-bit lanes
+static inline __m128i PackCells(__m128i a, __m128i b, uint8_t rc0, uint8_t rc1)
+{
+    __m128i x = _mm_unpacklo_epi64(a, b);
+
+    x = _mm_xor_si128(x, _mm_setr_epi32(rc0 & 0x0f, (rc0 >> 4) & 0x03, rc1 & 0x0f, (rc1 >> 4) & 0x03));
+    return _mm_maddubs_epi16(x, _mm_set1_epi16(0x0110));
+}
+
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    const __m128i pt = _mm_setr_epi8(9, 15, 8, 13, 10, 14, 12, 11, 0, 1, 2, 3, 4, 5, 6, 7);
+    __m128i tk1 = LoadCells(key);
+    __m128i tk2 = LoadCells(key + 8);
+    __m128i tk3 = LoadCells(key + 16);
+    __m128i t[4];
+    uint8_t i, j;
+
+    for (i = 0; i < 40; i += 4)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            t[j] = _mm_xor_si128(_mm_xor_si128(tk1, tk2), tk3);
+            tk1 = _mm_shuffle_epi8(tk1, pt);
+            tk2 = LFSR2(_mm_shuffle_epi8(tk2, pt));
+            tk3 = LFSR3(_mm_shuffle_epi8(tk3, pt));
+        }
+        _mm_storeu_si128((__m128i *)(roundKeys + 4 * i),
+                         _mm_packus_epi16(PackCells(t[0], t[1], RC[i], RC[i + 1]),
+                                          PackCells(t[2], t[3], RC[i + 2], RC[i + 3])));
+    }
+}
+
+#else
+static void PermuteTweakey(uint8_t *tk)
+{
+    static const uint8_t PT[16] = {9, 15, 8, 13, 10, 14, 12, 11, 0, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t tmp[16];
+    uint8_t j;
+
+    for (j = 0; j < 16; j++)
+    {
+        tmp[j] = tk[PT[j]];
+    }
+    for (j = 0; j < 16; j++)
+    {
+        tk[j] = tmp[j];
+    }
+}
+
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    /*
+     * Same layout as the assembly versions: the first two rows of
+     * TK1 ^ TK2 ^ TK3 (two cells per byte) with c0 and c1 added, 4 bytes
+     * per round.
+     */
+    uint8_t tk1[16], tk2[16], tk3[16];
+    uint8_t i, j;
+
+    for (j = 0; j < 8; j++)
+    {
+        tk1[2 * j] = key[j] >> 4;
+        tk1[2 * j + 1] = key[j] & 0x0f;
+        tk2[2 * j] = key[j + 8] >> 4;
+        tk2[2 * j + 1] = key[j + 8] & 0x0f;
+        tk3[2 * j] = key[j + 16] >> 4;
+        tk3[2 * j + 1] = key[j + 16] & 0x0f;
+    }
+    for (i = 0; i < 40; i++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            roundKeys[4 * i + j] = ((tk1[2 * j] ^ tk2[2 * j] ^ tk3[2 * j]) << 4) |
+                                   (tk1[2 * j + 1] ^ tk2[2 * j + 1] ^ tk3[2 * j + 1]);
+        }
+        roundKeys[4 * i + 0] ^= (RC[i] & 0x0f) << 4;
+        roundKeys[4 * i + 2] ^= RC[i] & 0x30;
+        PermuteTweakey(tk1);
+        PermuteTweakey(tk2);
+        PermuteTweakey(tk3);
+        // LFSRs of TK2 and TK3 on the first two rows
+        for (j = 0; j < 8; j++)
+        {
+            tk2[j] = ((tk2[j] << 1) & 0x0e) | (((tk2[j] >> 3) ^ (tk2[j] >> 2)) & 0x01);
+            tk3[j] = (tk3[j] >> 1) | (((tk3[j] << 3) ^ tk3[j]) & 0x08);
+        }
+    }
+}
+
+#endif
+#endif
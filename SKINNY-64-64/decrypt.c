@@ -0,0 +1,803 @@
+/*
+ * SKINNY-64-64
+ * @Time 2017
+ * @Author luopeng(luopeng@iie.ac.cn)
+ */
+
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * FELICS - Fair Evaluation of Lightweight Cryptographic Systems
+ *
+ * Copyright (C) 2015 University of Luxembourg
+ *
+ * Written in 2015 by Daniel Dinu <dumitru-daniel.dinu@uni.lu>
+ *
+ * This file is part of FELICS.
+ *
+ * FELICS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FELICS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+#include "cipher.h"
+#include "constants.h"
+
+/*
+ * Rounds per iteration of the round loop. The round body is repeated
+ * by the assembler (.rept), so this trades code size for loop overhead.
+ * If it equals the number of rounds, the AVR code has no round counter
+ * and no branch back.
+ */
+#ifndef UNROLL_FACTOR
+#define UNROLL_FACTOR 1
+#endif
+
+#if (32 % UNROLL_FACTOR) != 0
+#error "UNROLL_FACTOR must divide the number of rounds"
+#endif
+
+#define STR_(x) #x
+#define STR(x)  STR_(x)
+
+#ifdef AVR
+void Decrypt(uint8_t *block, uint8_t *roundKeys)
+{
+    /*--------------------------------------*/
+    /* r14-r21  : cipher text               */
+    /* r22-r23  : temp use                  */
+    /* r24      : loop control              */
+    /* r25      : const 0x02                */
+    /* r26-r27  : X points to cipher text   */
+    /* r28-r29  : Y points to roundKeys     */
+    /* r30-r31  : Z points to INV_SBOX      */
+    /* -------------------------------------*/
+    asm volatile(
+    /*
+     * http://www.atmel.com/webdoc/AVRLibcReferenceManual/FAQ_1faq_reg_usage.html
+     * 
+     * GCC AVR passes arguments from left to right in r25-r8.
+     * All arguments are aligned to start in even-numbered registers. 
+     * Pointers are 16-bits, so arguments are in r25:r24 and r23:22
+     * 
+     * [r18-r27, r30-r31]: You may use them freely in assembler subroutines.
+     *     The caller is responsible for saving and restoring.
+     * [r2-r17, r28-r29]: Calling C subroutines leaves them unchanged.
+     *     Assembler subroutines are responsible for saving and restoring these registers.
+     * [r0, r1]: Fixed registers. Never allocated by gcc for local data.
+     */
+        "push        r14        \n\t"
+        "push        r15        \n\t"
+        "push        r16        \n\t"
+        "push        r17        \n\t"
+        "push        r28        \n\t"
+        "push        r29        \n\t"
+        "movw        r28,          r22       \n\t"
+        // Load cipher text
+        "ld          r14,          x+        \n\t"
+        "ld          r15,          x+        \n\t"
+        "ld          r16,          x+        \n\t"
+        "ld          r17,          x+        \n\t"
+        "ld          r18,          x+        \n\t"
+        "ld          r19,          x+        \n\t"
+        "ld          r20,          x+        \n\t"
+        "ld          r21,          x         \n\t"
+        // Init
+        "adiw        r28,          63        \n\t"
+        "adiw        r28,          59        \n\t"
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "adiw        r28,          2         \n\t"
+        #else
+        // end of the last round keys, they are read with pre-decrement
+        "adiw        r28,          6         \n\t"
+        #endif
+        "ldi         r25,          0x20      \n\t"
+        "ldi         r31,          hi8(INV_SBOX)\n\t"
+        #if defined(SPEED_MODE)
+        // Fully unrolled. SubCells is done in place and the row
+        // rotation left by the inverse round is done by renaming:
+        // dec_round takes the register pairs holding the four rows.
+        // The order repeats every 8 rounds.
+        ".macro      dec_round a0, a1, b0, b1, c0, c1, d0, d1 \n\t"
+        // Inverse MixColumns
+        "eor         \\a0,        \\d0      \n\t"
+        "eor         \\d0,        \\b0      \n\t"
+        "eor         \\c0,        \\d0      \n\t"
+        "eor         \\a1,        \\d1      \n\t"
+        "eor         \\d1,        \\b1      \n\t"
+        "eor         \\c1,        \\d1      \n\t"
+        // Inverse ShiftRows, the second row is left to the renaming
+        "swap        \\c0                   \n\t"
+        "swap        \\c1                   \n\t"
+        "mov         r22,         \\c0      \n\t"
+        "eor         r22,         \\c1      \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         \\c0,        r22       \n\t"
+        "eor         \\c1,        r22       \n\t"
+        "swap        \\a0                   \n\t"
+        "swap        \\a1                   \n\t"
+        "mov         r22,         \\a0      \n\t"
+        "eor         r22,         \\a1      \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         \\a0,        r22       \n\t"
+        "eor         \\a1,        r22       \n\t"
+        // Inverse AddRoundTweakey and Inverse AddConstants
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "movw        r30,         r28       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\b0,        r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\b1,        r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\c0,        r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         \\c1,        r22       \n\t"
+        "eor         \\d1,        r25       \n\t"
+        "sbiw        r30,         8         \n\t"
+        "movw        r28,         r30       \n\t"
+        "ldi         r31,         hi8(INV_SBOX)\n\t"
+        #else
+        "ld          r22,         -y        \n\t"
+        "eor         \\c1,        r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         \\c0,        r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         \\b1,        r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         \\b0,        r22       \n\t"
+        "eor         \\d1,        r25       \n\t"
+        #endif
+        // Inverse SubCells, in place
+        "mov         r30,         \\a0      \n\t"
+        "lpm         \\a0,        z         \n\t"
+        "mov         r30,         \\a1      \n\t"
+        "lpm         \\a1,        z         \n\t"
+        "mov         r30,         \\b0      \n\t"
+        "lpm         \\b0,        z         \n\t"
+        "mov         r30,         \\b1      \n\t"
+        "lpm         \\b1,        z         \n\t"
+        "mov         r30,         \\c0      \n\t"
+        "lpm         \\c0,        z         \n\t"
+        "mov         r30,         \\c1      \n\t"
+        "lpm         \\c1,        z         \n\t"
+        "mov         r30,         \\d0      \n\t"
+        "lpm         \\d0,        z         \n\t"
+        "mov         r30,         \\d1      \n\t"
+        "lpm         \\d1,        z         \n\t"
+        ".endm       \n\t"
+        ".rept       4                      \n\t"
+        "dec_round   r14, r15, r16, r17, r18, r19, r20, r21 \n\t"
+        "dec_round   r16, r17, r18, r19, r21, r20, r14, r15 \n\t"
+        "dec_round   r18, r19, r21, r20, r15, r14, r16, r17 \n\t"
+        "dec_round   r21, r20, r15, r14, r17, r16, r18, r19 \n\t"
+        "dec_round   r15, r14, r17, r16, r19, r18, r21, r20 \n\t"
+        "dec_round   r17, r16, r19, r18, r20, r21, r15, r14 \n\t"
+        "dec_round   r19, r18, r20, r21, r14, r15, r17, r16 \n\t"
+        "dec_round   r20, r21, r14, r15, r16, r17, r19, r18 \n\t"
+        ".endr       \n\t"
+        ".purgem     dec_round              \n\t"
+        #else
+        #if UNROLL_FACTOR < 32
+        "ldi         r24,          32/" STR(UNROLL_FACTOR) "        \n\t"
+        #endif
+    "dec_loop:                               \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
+        // Inverse MixColumns
+        // eor s0,  s12
+        // eor s12, s4
+        // eor s8,  s12
+        "eor         r14,         r20        \n\t"
+        "eor         r20,         r16        \n\t"
+        "eor         r18,         r20        \n\t"
+        "eor         r15,         r21        \n\t"
+        "eor         r21,         r17        \n\t"
+        "eor         r19,         r21        \n\t"
+        // Inverse ShiftRows
+        "swap        r18                     \n\t"
+        "swap        r19                     \n\t"
+        "mov         r22,         r18        \n\t"
+        "eor         r22,         r19        \n\t"
+        "andi        r22,         0x0f       \n\t"
+        "eor         r18,         r22        \n\t"
+        "eor         r19,         r22        \n\t"
+        "swap        r14                     \n\t"
+        "swap        r15                     \n\t"
+        "mov         r22,         r14        \n\t"
+        "eor         r22,         r15        \n\t"
+        "andi        r22,         0xf0       \n\t"
+        "eor         r14,         r22        \n\t"
+        "eor         r15,         r22        \n\t"
+        // Inverse AddRoundTweakey and Inverse AddConstants
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "movw        r30,         r28        \n\t"
+        "lpm         r22,         z+         \n\t"
+        "eor         r16,         r22        \n\t"
+        "lpm         r22,         z+         \n\t"
+        "eor         r17,         r22        \n\t"
+        "lpm         r22,         z+         \n\t"
+        "eor         r18,         r22        \n\t"
+        "lpm         r22,         z+         \n\t"
+        "eor         r19,         r22        \n\t"
+        "eor         r21,         r25        \n\t"
+        "sbiw        r30,         8          \n\t"
+        "movw        r28,         r30        \n\t"
+        #else
+        "ld          r22,         -y         \n\t"
+        "eor         r19,         r22        \n\t"
+        "ld          r22,         -y         \n\t"
+        "eor         r18,         r22        \n\t"
+        "ld          r22,         -y         \n\t"
+        "eor         r17,         r22        \n\t"
+        "ld          r22,         -y         \n\t"
+        "eor         r16,         r22        \n\t"
+        "eor         r21,         r25        \n\t"
+        #endif
+        // Inverse SubCells
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "ldi         r31,         hi8(INV_SBOX)\n\t"
+        #endif
+        "movw        r22,         r14        \n\t"
+        "mov         r30,         r16        \n\t"
+        "lpm         r14,         z          \n\t"
+        "mov         r30,         r17        \n\t"
+        "lpm         r15,         z          \n\t"
+        "mov         r30,         r18        \n\t"
+        "lpm         r16,         z          \n\t"
+        "mov         r30,         r19        \n\t"
+        "lpm         r17,         z          \n\t"
+        "mov         r30,         r21        \n\t"
+        "lpm         r18,         z          \n\t"
+        "mov         r30,         r20        \n\t"
+        "lpm         r19,         z          \n\t"
+        "mov         r30,         r22        \n\t"
+        "lpm         r20,         z          \n\t"
+        "mov         r30,         r23        \n\t"
+        "lpm         r21,         z          \n\t"
+        ".endr                  \n\t"
+    #if UNROLL_FACTOR < 32
+    "dec             r24                     \n\t"
+    #if UNROLL_FACTOR > 1
+    "breq            dec_exit                \n\t"
+    "rjmp            dec_loop                \n\t"
+    "dec_exit:                               \n\t"
+    #else
+    "brne            dec_loop                \n\t"
+    #endif
+    #endif
+        #endif
+        // Store cipher text
+        "st          x,           r21        \n\t"
+        "st          -x,          r20        \n\t"
+        "st          -x,          r19        \n\t"
+        "st          -x,          r18        \n\t"
+        "st          -x,          r17        \n\t"
+        "st          -x,          r16        \n\t"
+        "st          -x,          r15        \n\t"
+        "st          -x,          r14        \n\t"
+        "pop         r29        \n\t"
+        "pop         r28        \n\t"
+        "pop         r17        \n\t"
+        "pop         r16        \n\t"
+        "pop         r15        \n\t"
+        "pop         r14        \n\t"
+    :
+    : [block] "x" (block), [roundKeys] "" (roundKeys), [INV_SBOX] "" (INV_SBOX));
+}
+
+void Decrypt2(uint8_t *block, uint8_t *roundKeys)
+{
+    /*--------------------------------------*/
+    /* r14-r21  : first cipher text         */
+    /* r6-r13   : second cipher text        */
+    /* r4-r5    : temp use (second block)   */
+    /* r22-r23  : temp use                  */
+    /* r24      : loop control              */
+    /* r25      : const 0x02                */
+    /* r26-r27  : X points to cipher text   */
+    /* r28-r29  : Y points to roundKeys     */
+    /* r30-r31  : Z points to INV_SBOX      */
+    /*--------------------------------------*/
+    asm volatile(
+        "push        r4         \n\t"
+        "push        r5         \n\t"
+        "push        r6         \n\t"
+        "push        r7         \n\t"
+        "push        r8         \n\t"
+        "push        r9         \n\t"
+        "push        r10        \n\t"
+        "push        r11        \n\t"
+        "push        r12        \n\t"
+        "push        r13        \n\t"
+        "push        r14        \n\t"
+        "push        r15        \n\t"
+        "push        r16        \n\t"
+        "push        r17        \n\t"
+        "push        r28        \n\t"
+        "push        r29        \n\t"
+        "movw        r28,         r22       \n\t"
+        // Load cipher text, the second block follows the first
+        "ld          r14,         x+        \n\t"
+        "ld          r15,         x+        \n\t"
+        "ld          r16,         x+        \n\t"
+        "ld          r17,         x+        \n\t"
+        "ld          r18,         x+        \n\t"
+        "ld          r19,         x+        \n\t"
+        "ld          r20,         x+        \n\t"
+        "ld          r21,         x+        \n\t"
+        "ld          r6,          x+        \n\t"
+        "ld          r7,          x+        \n\t"
+        "ld          r8,          x+        \n\t"
+        "ld          r9,          x+        \n\t"
+        "ld          r10,         x+        \n\t"
+        "ld          r11,         x+        \n\t"
+        "ld          r12,         x+        \n\t"
+        "ld          r13,         x         \n\t"
+        // Init
+        "adiw        r28,         63        \n\t"
+        "adiw        r28,         59        \n\t"
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "adiw        r28,         2         \n\t"
+        #else
+        // end of the last round keys, they are read with pre-decrement
+        "adiw        r28,         6         \n\t"
+        #endif
+        #if UNROLL_FACTOR < 32
+        "ldi         r24,         32/" STR(UNROLL_FACTOR) "        \n\t"
+        #endif
+        "ldi         r25,         0x20      \n\t"
+        "ldi         r31,         hi8(INV_SBOX)\n\t"
+    "dec2_loop:                             \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
+        // Inverse MixColumns
+        "eor         r14,         r20       \n\t"
+        "eor         r20,         r16       \n\t"
+        "eor         r18,         r20       \n\t"
+        "eor         r15,         r21       \n\t"
+        "eor         r21,         r17       \n\t"
+        "eor         r19,         r21       \n\t"
+        "eor         r6,          r12       \n\t"
+        "eor         r12,         r8        \n\t"
+        "eor         r10,         r12       \n\t"
+        "eor         r7,          r13       \n\t"
+        "eor         r13,         r9        \n\t"
+        "eor         r11,         r13       \n\t"
+        // Inverse ShiftRows
+        "swap        r18                    \n\t"
+        "swap        r19                    \n\t"
+        "mov         r22,         r18       \n\t"
+        "eor         r22,         r19       \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         r18,         r22       \n\t"
+        "eor         r19,         r22       \n\t"
+        "swap        r14                    \n\t"
+        "swap        r15                    \n\t"
+        "mov         r22,         r14       \n\t"
+        "eor         r22,         r15       \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         r14,         r22       \n\t"
+        "eor         r15,         r22       \n\t"
+        "swap        r10                    \n\t"
+        "swap        r11                    \n\t"
+        "mov         r22,         r10       \n\t"
+        "eor         r22,         r11       \n\t"
+        "andi        r22,         0x0f      \n\t"
+        "eor         r10,         r22       \n\t"
+        "eor         r11,         r22       \n\t"
+        "swap        r6                     \n\t"
+        "swap        r7                     \n\t"
+        "mov         r22,         r6        \n\t"
+        "eor         r22,         r7        \n\t"
+        "andi        r22,         0xf0      \n\t"
+        "eor         r6,          r22       \n\t"
+        "eor         r7,          r22       \n\t"
+        // Inverse AddRoundTweakey and Inverse AddConstants, the round keys are loaded once
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "movw        r30,         r28       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r16,         r22       \n\t"
+        "eor         r8,          r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r17,         r22       \n\t"
+        "eor         r9,          r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r18,         r22       \n\t"
+        "eor         r10,         r22       \n\t"
+        "lpm         r22,         z+        \n\t"
+        "eor         r19,         r22       \n\t"
+        "eor         r11,         r22       \n\t"
+        "eor         r21,         r25       \n\t"
+        "eor         r13,         r25       \n\t"
+        "sbiw        r30,         8         \n\t"
+        "movw        r28,         r30       \n\t"
+        #else
+        "ld          r22,         -y        \n\t"
+        "eor         r19,         r22       \n\t"
+        "eor         r11,         r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         r18,         r22       \n\t"
+        "eor         r10,         r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         r17,         r22       \n\t"
+        "eor         r9,          r22       \n\t"
+        "ld          r22,         -y        \n\t"
+        "eor         r16,         r22       \n\t"
+        "eor         r8,          r22       \n\t"
+        "eor         r21,         r25       \n\t"
+        "eor         r13,         r25       \n\t"
+        #endif
+        // Inverse SubCells
+        #if defined(SCENARIO) && (SCENARIO_2 == SCENARIO)
+        "ldi         r31,         hi8(INV_SBOX)\n\t"
+        #endif
+        "movw        r22,         r14       \n\t"
+        "mov         r30,         r16       \n\t"
+        "lpm         r14,         z         \n\t"
+        "mov         r30,         r17       \n\t"
+        "lpm         r15,         z         \n\t"
+        "mov         r30,         r18       \n\t"
+        "lpm         r16,         z         \n\t"
+        "mov         r30,         r19       \n\t"
+        "lpm         r17,         z         \n\t"
+        "mov         r30,         r21       \n\t"
+        "lpm         r18,         z         \n\t"
+        "mov         r30,         r20       \n\t"
+        "lpm         r19,         z         \n\t"
+        "mov         r30,         r22       \n\t"
+        "lpm         r20,         z         \n\t"
+        "mov         r30,         r23       \n\t"
+        "lpm         r21,         z         \n\t"
+        "movw        r4,          r6        \n\t"
+        "mov         r30,         r8        \n\t"
+        "lpm         r6,          z         \n\t"
+        "mov         r30,         r9        \n\t"
+        "lpm         r7,          z         \n\t"
+        "mov         r30,         r10       \n\t"
+        "lpm         r8,          z         \n\t"
+        "mov         r30,         r11       \n\t"
+        "lpm         r9,          z         \n\t"
+        "mov         r30,         r13       \n\t"
+        "lpm         r10,         z         \n\t"
+        "mov         r30,         r12       \n\t"
+        "lpm         r11,         z         \n\t"
+        "mov         r30,         r4        \n\t"
+        "lpm         r12,         z         \n\t"
+        "mov         r30,         r5        \n\t"
+        "lpm         r13,         z         \n\t"
+        ".endr                  \n\t"
+    #if UNROLL_FACTOR < 32
+    "dec             r24                    \n\t"
+    "breq            dec2_exit              \n\t"
+    "rjmp            dec2_loop              \n\t"
+    "dec2_exit:                             \n\t"
+    #endif
+        // Store plain text
+        "st          x,           r13       \n\t"
+        "st          -x,          r12       \n\t"
+        "st          -x,          r11       \n\t"
+        "st          -x,          r10       \n\t"
+        "st          -x,          r9        \n\t"
+        "st          -x,          r8        \n\t"
+        "st          -x,          r7        \n\t"
+        "st          -x,          r6        \n\t"
+        "st          -x,          r21       \n\t"
+        "st          -x,          r20       \n\t"
+        "st          -x,          r19       \n\t"
+        "st          -x,          r18       \n\t"
+        "st          -x,          r17       \n\t"
+        "st          -x,          r16       \n\t"
+        "st          -x,          r15       \n\t"
+        "st          -x,          r14       \n\t"
+        "pop         r29        \n\t"
+        "pop         r28        \n\t"
+        "pop         r17        \n\t"
+        "pop         r16        \n\t"
+        "pop         r15        \n\t"
+        "pop         r14        \n\t"
+        "pop         r13        \n\t"
+        "pop         r12        \n\t"
+        "pop         r11        \n\t"
+        "pop         r10        \n\t"
+        "pop         r9         \n\t"
+        "pop         r8         \n\t"
+        "pop         r7         \n\t"
+        "pop         r6         \n\t"
+        "pop         r5         \n\t"
+        "pop         r4         \n\t"
+    :
+    : [block] "x" (block), [roundKeys] "" (roundKeys), [INV_SBOX] "" (INV_SBOX));
+}
+
+#elif defined MSP
+void Decrypt(uint8_t *block, uint8_t *roundKeys)
+{
+    /* r4-r7   : cipher state                */
+    /* r10-r12 : temp use                    */
+    /* r13     : currentRound                */
+    /* r14     : point to round keys         */
+    /* r15     : point to block              */
+    asm volatile(
+        #if defined(__MSP430X__)
+        "pushm       #4,        r7         \n\t"
+        "pushm       #2,        r11        \n\t"
+        #else
+        "push        r4         \n\t"
+        "push        r5         \n\t"
+        "push        r6         \n\t"
+        "push        r7         \n\t"
+        "push        r10        \n\t"
+        "push        r11        \n\t"
+        #endif
+        // Init
+        "mov         #32/" STR(UNROLL_FACTOR) ",           r13      \n\t"
+        "add         #124,          r14      \n\t"
+        "mov         0(r15),        r4       \n\t"
+        "mov         2(r15),        r5       \n\t"
+        "mov         4(r15),        r6       \n\t"
+        "mov         6(r15),        r7       \n\t"
+    "dec_loop:                               \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
+        // Inverse MixColumns
+        // xor s12, s0 
+        // xor s4,  s12
+        // xor s12, s8 
+        "xor         r7,            r4       \n\t"
+        "xor         r5,            r7       \n\t"
+        "xor         r7,            r6       \n\t"
+        // Inverse ShiftRows
+        "rla         r6                      \n\t"
+        "adc         r6                      \n\t"
+        "rla         r6                      \n\t"
+        "adc         r6                      \n\t"
+        "rla         r6                      \n\t"
+        "adc         r6                      \n\t"
+        "rla         r6                      \n\t"
+        "adc         r6                      \n\t"
+        "swpb        r7                      \n\t"
+        "bit         #1,            r4       \n\t"
+        "rrc         r4                      \n\t"
+        "bit         #1,            r4       \n\t"
+        "rrc         r4                      \n\t"
+        "bit         #1,            r4       \n\t"
+        "rrc         r4                      \n\t"
+        "bit         #1,            r4       \n\t"
+        "rrc         r4                      \n\t"
+        //Inverse AddRoundTweakey, Inverse AddConstants
+        // and Inverse SubCells
+        "xor         @r14+,         r5       \n\t"
+        "mov.b       r5,            r12      \n\t" 
+        "mov.b       INV_SBOX(r12), r11      \n\t"
+        "swpb        r5                      \n\t"
+        "mov.b       r5,            r12      \n\t"
+        "mov.b       INV_SBOX(r12), r10      \n\t"
+        "swpb        r10                     \n\t"
+        "xor         r11,           r10      \n\t" // first line
+		"xor         @r14+,         r6       \n\t"
+        "mov.b       r6,            r12      \n\t" 
+        "mov.b       INV_SBOX(r12), r11      \n\t"
+        "swpb        r6                      \n\t"
+        "mov.b       r6,            r12      \n\t"
+        "mov.b       INV_SBOX(r12), r5       \n\t"
+        "swpb        r5                      \n\t"
+        "xor         r11,           r5       \n\t" // second line
+		"xor         #0x20,         r7       \n\t"
+        "mov.b       r7,            r12      \n\t" 
+        "mov.b       INV_SBOX(r12), r11      \n\t"
+        "swpb        r7                      \n\t"
+        "mov.b       r7,            r12      \n\t"
+        "mov.b       INV_SBOX(r12), r6       \n\t"
+        "swpb        r6                      \n\t"
+        "xor         r11,           r6       \n\t" // third line
+        "mov.b       r4,            r12      \n\t" 
+        "mov.b       INV_SBOX(r12), r11      \n\t"
+        "swpb        r4                      \n\t"
+        "mov.b       r4,            r12      \n\t"
+        "mov.b       INV_SBOX(r12), r7       \n\t"
+        "swpb        r7                      \n\t"
+        "xor         r11,           r7       \n\t" // fourth line        
+        "mov         r10,           r4       \n\t"
+        "sub         #8,            r14      \n\t"  
+        ".endr                  \n\t"
+    "dec             r13                     \n\t"
+    #if UNROLL_FACTOR > 1
+    "jeq             dec_exit                \n\t"
+    "br              #dec_loop               \n\t"
+    "dec_exit:                               \n\t"
+    #else
+    "jne             dec_loop                \n\t"
+    #endif
+        "mov         r4,            0(r15),  \n\t"
+        "mov         r5,            2(r15),  \n\t"
+        "mov         r6,            4(r15),  \n\t"
+        "mov         r7,            6(r15),  \n\t"
+        #if defined(__MSP430X__)
+        "popm        #2,        r11        \n\t"
+        "popm        #4,        r7         \n\t"
+        #else
+        "pop         r11        \n\t"
+        "pop         r10        \n\t"
+        "pop         r7         \n\t"
+        "pop         r6         \n\t"
+        "pop         r5         \n\t"
+        "pop         r4         \n\t"
+        #endif
+    :
+    : [block] "m" (block), [roundKeys] "m" (roundKeys), [INV_SBOX] "" (INV_SBOX));
+}
+
+#elif defined ARM
+void Decrypt(uint8_t *block, uint8_t *roundKeys) {
+
+    // r0    : ponits to ciphertext
+    // r1    : points to roundKeys
+    // r2-r5 : cipher state
+    // r6-r7 : temp use
+    // r8    : loop control
+    // r9    : points to INV_SBOX
+    // r10   : 0xff
+    asm volatile(
+        "stmdb      sp!,      {r2-r10}         \n\t"
+        "mov        r8,       #32/" STR(UNROLL_FACTOR) "              \n\t"
+        "movw       r9,       #:lower16:INV_SBOX       \n\t"
+        "movt       r9,       #:upper16:INV_SBOX       \n\t"
+        "mov        r10,      #0xff            \n\t"
+        "adds       r1,       r1, #124         \n\t"
+        // r2 (--  --  --  --  s2  s3  s0  s1)
+        // r3 (--  --  --  --  s6  s7  s4  s5)
+        // r4 (--  --  --  --  s10 s11 s8  s9)
+        // r5 (--  --  --  --  s14 s15 s12 s13)
+        "ldrd       r2, r4,   [r0, #0]         \n\t"
+        "mov        r3,       r2, lsr #16      \n\t"
+        "mov        r5,       r4, lsr #16      \n\t"
+    "enc_loop:                                 \n\t"
+        ".rept       " STR(UNROLL_FACTOR) "      \n\t"
+        // Inverse MixColumns
+        "eors       r2,       r2, r5           \n\t"
+        "eors       r5,       r5, r3           \n\t"
+        "eors       r4,       r4, r5           \n\t"
+        // Inverse ShiftRows
+        "bfi        r4,       r4, #16, #12     \n\t"
+        "lsr        r4,       r4, #12          \n\t"
+        "rev16      r5,       r5               \n\t"
+        "bfi        r2,       r2, #16, #4      \n\t"
+        "lsr        r2,       r2, #4           \n\t"
+        // Inverse AddRoundTweakey and Inverse AddConstants
+        "ldr        r6,       [r1,#0]          \n\t"
+        "subs       r1,       r1, #4           \n\t"
+        "eors       r3,       r3, r6           \n\t"
+        "eors       r4,       r4, r6, lsr #16  \n\t"
+        "eors       r5,       r5, #0x20        \n\t"
+        // Inverse SubCells
+        // fourth line, store r7 for temp
+        "and        r6,       r2, #0xff        \n\t"
+        "ldrb       r6,       [r9,r6]          \n\t"
+        "bfi        r7,r6,    #0, #8           \n\t"
+        "and        r6,       r10, r2, lsr #8  \n\t"
+        "ldrb       r6,       [r9,r6]          \n\t"
+        "bfi        r7,r6,    #8, #8           \n\t"
+        // first line
+        "and        r6,       r3, #0xff        \n\t"
+        "ldrb       r6,       [r9,r6]          \n\t"
+        "bfi        r2,r6,    #0, #8           \n\t"
+        "and        r6,       r10, r3, lsr #8  \n\t"
+        "ldrb       r6,       [r9,r6]          \n\t"
+        "bfi        r2,r6,    #8, #8           \n\t"
+        // second line
+        "and        r6,       r4, #0xff        \n\t"
+        "ldrb       r6,       [r9,r6]          \n\t"
+        "bfi        r3,r6,    #0, #8           \n\t"
+        "and        r6,       r10, r4, lsr #8  \n\t"
+        "ldrb       r6,       [r9,r6]          \n\t"
+        "bfi        r3,r6,    #8, #8           \n\t"
+        // third line
+        "and        r6,       r5, #0xff        \n\t"
+        "ldrb       r6,       [r9,r6]          \n\t"
+        "bfi        r4,r6,    #0, #8           \n\t"
+        "and        r6,       r10, r5, lsr #8  \n\t"
+        "ldrb       r6,       [r9,r6]          \n\t"
+        "bfi        r4,r6,    #8, #8           \n\t"
+        // recover the first line
+        "mov        r5,       r7               \n\t"
+        ".endr                  \n\t"
+    "subs           r8,       r8, #1           \n\t"
+    "bne            enc_loop                   \n\t"
+        "bfi        r2,       r3, #16, #16     \n\t"
+        "bfi        r4,       r5, #16, #16     \n\t"
+        "strd       r2, r4,   [r0, #0]         \n\t"
+        "ldmia      sp!,      {r2-r10}         \n\t"
+    :
+    : [block] "r" (block), [roundKeys] "r" (roundKeys), [INV_SBOX] "" (INV_SBOX));
+}
+
+#else
+/*
+ * Portable version for hosts without SIMD. The block is one 64-bit
+ * word with s0 in the top nibble, so row i is the 16-bit lane at bit
+ * 48 - 16*i.
+ */
+static inline uint64_t sbox_mix(uint64_t x)
+{
+    return x ^ (~((x >> 3) | (x >> 2)) & 0x1111111111111111ULL);
+}
+
+static inline uint64_t InvSubCells(uint64_t x)
+{
+    // x0 ^= ~(x3 | x2), then rotate each nibble right by one bit
+    x = sbox_mix(x);
+    x = ((x >> 1) & 0x7777777777777777ULL) | ((x << 3) & 0x8888888888888888ULL);
+    x = sbox_mix(x);
+    x = ((x >> 1) & 0x7777777777777777ULL) | ((x << 3) & 0x8888888888888888ULL);
+    x = sbox_mix(x);
+    x = ((x >> 1) & 0x7777777777777777ULL) | ((x << 3) & 0x8888888888888888ULL);
+    return sbox_mix(x);
+}
+
+static inline uint64_t InvShiftRows(uint64_t x)
+{
+    // row i is rotated left by 4*i bits
+    return (x & 0xffff000000000000ULL) |
+           ((x << 4) & 0x0000fff000000000ULL) |
+           ((x >> 12) & 0x0000000f00000000ULL) |
+           ((x >> 8) & 0x0000000000ff0000ULL) |
+           ((x << 8) & 0x00000000ff000000ULL) |
+           ((x >> 4) & 0x0000000000000fffULL) |
+           ((x << 12) & 0x000000000000f000ULL);
+}
+
+static inline uint64_t InvMixColumns(uint64_t x)
+{
+    uint16_t r0 = x >> 48, r1 = x >> 32, r2 = x >> 16, r3 = x;
+
+    r3 ^= r1;
+    r2 ^= r3;
+    r0 ^= r3 ^ r1;
+    return ((uint64_t)r1 << 48) | ((uint64_t)r2 << 32) | ((uint64_t)r3 << 16) | r0;
+}
+
+void Decrypt(uint8_t *block, uint8_t *roundKeys)
+{
+    uint64_t s = 0;
+    uint32_t k;
+    uint8_t i;
+
+    for (i = 0; i < 8; i++)
+    {
+        s = (s << 8) | block[i];
+    }
+    for (i = 32; i > 0; i--)
+    {
+        k = ((uint32_t)roundKeys[4 * i - 4] << 24) | ((uint32_t)roundKeys[4 * i - 3] << 16) |
+            ((uint32_t)roundKeys[4 * i - 2] << 8) | roundKeys[4 * i - 1];
+        s = InvMixColumns(s);
+        s = InvShiftRows(s);
+        s = InvSubCells(s ^ ((uint64_t)k << 32) ^ 0x20000000);
+    }
+    for (i = 8; i > 0; i--)
+    {
+        block[i - 1] = s;
+        s >>= 8;
+    }
+}
+
+#endif
+
+#ifndef AVR
+void Decrypt2(uint8_t *block, uint8_t *roundKeys)
+{
+    Decrypt(block, roundKeys);
+    Decrypt(block + 8, roundKeys);
+}
+#endif
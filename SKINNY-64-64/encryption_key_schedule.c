@@ -0,0 +1,412 @@
+/*
+ * SKINNY-64-64
+ * @Time 2017
+ * @Author luopeng(luopeng@iie.ac.cn)
+ */
+
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * FELICS - Fair Evaluation of Lightweight Cryptographic Systems
+ *
+ * Copyright (C) 2015 University of Luxembourg
+ *
+ * Written in 2015 by Daniel Dinu <dumitru-daniel.dinu@uni.lu>
+ *
+ * This file is part of FELICS.
+ *
+ * FELICS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FELICS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+#include "cipher.h"
+#include "constants.h"
+
+#ifdef AVR
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    /*--------------------------------------*/
+    // Round keys and round constants are eor-ed
+    // and stored together
+    /* r5      : 0x0f                       */
+    /* r6,r7,r24,r25 : temp                 */
+    /* r8-r15  : master keys                */
+    /* r26     : loop control               */
+    /* r27     : 0xf0                       */
+    /* r26-r27 : X points to master keys    */
+    /* r28-r29 : Y points to roundKeys      */
+    /* r30-r31 : Z points to RC             */
+    /* -------------------------------------*/
+    asm volatile(
+    	"push         r5         \n\t"
+        "push         r6         \n\t"
+        "push         r7         \n\t"
+        "push         r8         \n\t"
+        "push         r9         \n\t"
+        "push         r10        \n\t"
+        "push         r11        \n\t"
+        "push         r12        \n\t"
+        "push         r13        \n\t"
+        "push         r14        \n\t"
+        "push         r15        \n\t"
+        "push         r28        \n\t"
+        "push         r29        \n\t"
+        "movw         r26,        r24       \n\t"
+        "movw         r28,        r22       \n\t"
+        // Load keys
+        // Tweak1
+        // r8  r9
+        // r10 r11
+        // r12 r13
+        // r14 r15
+        // 
+        "ld           r8,         x+        \n\t"
+        "ld           r9,         x+        \n\t"
+        "ld           r10,        x+        \n\t"
+        "ld           r11,        x+        \n\t"
+        "ld           r12,        x+        \n\t"
+        "ld           r13,        x+        \n\t"
+        "ld           r14,        x+        \n\t"
+        "ld           r15,        x+        \n\t"
+        // Init
+        "ldi          r26,        32        \n\t"
+        "ldi          r27,        0x0f      \n\t"
+        "mov          r5,         r27       \n\t"
+        "ldi          r27,        0xf0      \n\t"
+        "ldi          r30,        lo8(RC)   \n\t"
+        "ldi          r31,        hi8(RC)   \n\t"
+    "key_schedule_start:                    \n\t"
+        // XOR RoundConstant and the TweakKey together
+        "lpm          r24,        z+        \n\t"
+        "mov          r25,        r24       \n\t"
+        "andi         r25,        0x0f      \n\t"
+        "swap         r25                   \n\t"
+        "mov          r6,         r8        \n\t" // store k0
+        "eor          r6,         r25       \n\t"
+        "st           y+,         r6        \n\t"
+        "st           y+,         r9        \n\t" // store k1
+        "andi         r24,        0x30      \n\t" // store k2
+        "mov          r6,         r10       \n\t"
+        "eor          r6,         r24       \n\t"
+        "st           y+,         r6        \n\t"
+        "st           y+,         r11       \n\t" // store k3
+        // (k0  k1 ) (k2  k3 )        (k9  k15) (k8  k13)
+        // (k4  k5 ) (k6  k7 )        (k10 k14) (k12 k11)
+        // (k8  k9 ) (k10 k11) -----> (k0  k1 ) (k2  k3 )
+        // (k12 k13) (k14 k15)        (k4  k5 ) (k6  k7 )
+        "movw         r6,         r12       \n\t"
+        "movw         r12,        r8        \n\t"
+        "movw         r8,         r14       \n\t"
+        "movw         r14,        r10       \n\t"
+        "mov          r11,        r7        \n\t"
+        "and          r11,        r5        \n\t"
+        "mov          r10,        r8        \n\t"
+        "and          r10,        r27       \n\t"
+        "eor          r11,        r10       \n\t"
+        "mov          r10,        r7        \n\t"
+        "and          r10,        r27       \n\t"
+        "mov          r7,         r9        \n\t"
+        "and          r7,         r27       \n\t"
+        "swap         r7                    \n\t"
+        "eor          r10,        r7        \n\t"
+        "mov          r7,         r8        \n\t"
+        "and          r7,         r5        \n\t"
+        "mov          r8,         r6        \n\t"
+        "and          r8,         r27       \n\t"
+        "eor          r7,         r8        \n\t"
+        "mov          r8,         r9        \n\t"
+        "and          r8,         r5        \n\t"
+        "swap         r6                    \n\t"
+        "and          r6,         r27       \n\t"
+        "eor          r8,         r6        \n\t"
+        "mov          r9,         r7        \n\t"
+    "dec              r26                   \n\t"
+    "brne             key_schedule_start    \n\t"
+        "pop          r29         \n\t"
+        "pop          r28         \n\t"
+        "pop          r15         \n\t"
+        "pop          r14         \n\t"
+        "pop          r13         \n\t"
+        "pop          r12         \n\t"
+        "pop          r11         \n\t"
+        "pop          r10         \n\t"
+        "pop          r9          \n\t"
+        "pop          r8          \n\t"
+        "pop          r7          \n\t"
+        "pop          r6          \n\t"
+        "pop          r5          \n\t"
+        :
+        : [key] "" (key), [roundKeys] "" (roundKeys), [RC] "" (RC));
+}
+
+#elif defined MSP
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    /* r4-r7   : key state                   */
+    /* r8      : currentRound                */
+    /* r12-r13 : temp use                    */
+    /* r14     : point to roundKeys          */
+    /* r15     : point to key and RC         */
+    asm volatile (
+        /*
+         * [r15-r12]: In MSPGCC, registers are passed starting with R15 and descending to R12.
+         *     For example, if two integers are passed,
+         *     the first is passed in R15 and the second is passed in R14.
+         * [r11-r4]:  r11-r4 must be pushed if used.
+         */
+        #if defined(__MSP430X__)
+        "pushm        #5,           r8            \n\t"
+        #else
+        "push         r4            \n\t"
+        "push         r5            \n\t"
+        "push         r6            \n\t"
+        "push         r7            \n\t"
+        "push         r8            \n\t"
+        #endif
+        // Load master keys
+        "mov          @r15+,        r4            \n\t"
+        "mov          @r15+,        r5            \n\t"
+        "mov          @r15+,        r6            \n\t"
+        "mov          @r15+,        r7            \n\t"
+        "mov          %[RC],        r15           \n\t"
+        "mov          #32,          r8            \n\t"
+    "extend_loop:                                 \n\t"
+        // AddRoundConstant
+        "mov.b        @r15,         r12           \n\t"
+        "and          #0x000f,      r12           \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #4,           r12           \n\t"
+        #else
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        "rla          r12                         \n\t"
+        #endif
+        "xor          r4,           r12           \n\t"
+        "mov          r12,          0(r14)        \n\t"
+        "mov.b        @r15+,        r12           \n\t"
+        "and          #0x0030,      r12           \n\t"
+        "xor          r5,           r12           \n\t"
+        "mov          r12,          2(r14)        \n\t"
+        "add          #4,           r14           \n\t"
+        // Permutation
+        // r4 (k2  k3  k0  k1)          r4 (k8 k13  k9  k15)
+        // r5 (k6  k7  k4  k5)          r5 (k12 k11 k10 k14)
+        // r6 (k10 k11 k8  k9)   -----> r6 (k2  k3  k0  k1)
+        // r7 (k14 k15 k12 k13)         r7 (k6  k7  k4  k5)
+        // First row
+        "mov          r6,           r12           \n\t"
+        "mov          r4,           r6            \n\t"
+        "mov          r7,           r4            \n\t"
+        "mov          r5,           r7            \n\t"
+        "swpb         r4                          \n\t"
+        "mov          r4,           r13           \n\t"
+        "and          #0x0f0f,      r4            \n\t"
+        "mov          r12,          r5            \n\t"
+        #if defined(__MSP430X__)
+        "rlam         #4,           r5            \n\t"
+        #else
+        "rla          r5                          \n\t"
+        "rla          r5                          \n\t"
+        "rla          r5                          \n\t"
+        "rla          r5                          \n\t"
+        #endif
+        "and          #0xf0,        r5            \n\t"
+        "xor          r5,           r4            \n\t"
+        "mov          r12,          r5            \n\t"
+        "swpb         r5                          \n\t"
+        "and          #0xf000,      r5            \n\t"
+        "xor          r5,           r4            \n\t"
+        // Second row
+        "mov          r12,          r5            \n\t"
+        "and          #0x0f00,      r5            \n\t"
+        "swpb         r12                         \n\t"
+        "and          #0xf0,        r12           \n\t"
+        "xor          r12,          r5            \n\t"
+        "mov          r13,          r12           \n\t"
+        #if defined(__MSP430X__)
+        "rram         #4,           r12           \n\t"
+        #else
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        "rra          r12                         \n\t"
+        #endif
+        "and          #0xf,         r12           \n\t"
+        "xor          r12,          r5            \n\t"
+        "and          #0xf000,      r13           \n\t"
+        "xor          r13,          r5            \n\t"
+    "dec              r8                          \n\t"
+    "jne              extend_loop                 \n\t"
+        /* ----------------------------------------- */
+        #if defined(__MSP430X__)
+        "popm         #5,           r8            \n\t"
+        #else
+        "pop          r8            \n\t"
+        "pop          r7            \n\t"
+        "pop          r6            \n\t"
+        "pop          r5            \n\t"
+        "pop          r4            \n\t"    
+        #endif
+    :
+    : [key] "m" (key), [roundKeys] "m" (roundKeys), [RC] "" (RC));
+}
+
+#elif defined ARM
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    // r0    : ponits to key
+    // r1    : points to roundKeys
+    // r2-r3 : key state
+    // r6-r7 : temp use
+    // r8    : loop control
+    // r9    : points to RC
+    // r10   : 0xf00f0
+    // r11   : 0xf00f0f
+    asm volatile(
+        "stmdb      sp!,      {r2-r11}        \n\t"
+        "mov        r8,       #32             \n\t"
+        "ldr        r9,       =RC             \n\t"
+        "mov        r10,      #0xf            \n\t"
+        "lsl        r10,      #16             \n\t"
+        "eors       r10,      r10, #0xf0      \n\t"
+        "mov        r11,      r10, lsl #4     \n\t"
+        "eors       r11,      r11, #0xf       \n\t"
+        "ldmia      r0,       {r2-r3}         \n\t" // load master key
+    "key_loop:                                \n\t"
+        "ldrb       r6,       [r9]            \n\t"
+        "adds       r9,       r9, #1          \n\t"
+        "mov        r7,       r6, lsl #16     \n\t"
+        "and        r6,       r6, #0xf        \n\t"
+        "eors       r6,       r2, r6, lsl #4  \n\t"
+        "and        r7,       r7, #0x300000  \n\t"
+        "eors       r6,       r6, r7         \n\t"
+        "str        r6,       [r1,#0]         \n\t" // store round keys
+        "adds       r1,       r1, #4          \n\t"
+        // Permutation
+        // r2(k6  k7  k4  k5  k2  k3  k0  k1)    k12 k11 k10 k14 k8  k13 k9 k15
+        // r3(k14 k15 k12 k13 k10 k11 k8  k9) -> k6  k7  k4  k5  k2  k3  k0  k1
+        "mov        r6,       r3              \n\t" 
+        "mov        r3,       r2              \n\t"
+        "rev        r2,       r6              \n\t"
+        "ands       r2,       r2, r11         \n\t"
+        "mov        r7,       r6, lsl #8      \n\t"
+        "and        r7,       r7, #0xf000f000 \n\t"
+        "eors       r2,       r2, r7          \n\t"
+        "rev16      r7,       r6              \n\t"
+        "and        r7,       r10, r7, lsr #4 \n\t"
+        "eors       r2,       r2, r7          \n\t"
+        "and        r6,       r6, #0xf00      \n\t"
+        "eors       r2,       r2, r6, lsl #16 \n\t"
+    "subs           r8,       r8, #1          \n\t"
+    "bne            key_loop                  \n\t"
+        "ldmia      sp!,      {r2-r11}        \n\t"
+    :
+    : [key] "r" (key), [roundKeys] "r" (roundKeys), [RC] "" (RC));
+}
+
+#else
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+
+/*
+ * One cell per byte, so PT is a single pshufb. Four rounds are stored
+ * per iteration from TK1 permuted by PT^0 ... PT^3.
+ */
+static inline __m128i LoadCells(uint8_t *key)
+{
+    __m128i x = _mm_loadl_epi64((__m128i *)key);
+    __m128i m = _mm_set1_epi8(0x0f);
+
+    return _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(x, 4), m), _mm_and_si128(x, m));
+}
+
+// two rounds of cells (with c0 and c1) to 8 bytes in 16-bit lanes
+static inline __m128i PackCells(__m128i a, __m128i b, uint8_t rc0, uint8_t rc1)
+{
+    __m128i x = _mm_unpacklo_epi64(a, b);
+
+    x = _mm_xor_si128(x, _mm_setr_epi32(rc0 & 0x0f, (rc0 >> 4) & 0x03, rc1 & 0x0f, (rc1 >> 4) & 0x03));
+    return _mm_maddubs_epi16(x, _mm_set1_epi16(0x0110));
+}
+
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    const __m128i pt = _mm_setr_epi8(9, 15, 8, 13, 10, 14, 12, 11, 0, 1, 2, 3, 4, 5, 6, 7);
+    const __m128i pt2 = _mm_setr_epi8(1, 7, 0, 5, 2, 6, 4, 3, 9, 15, 8, 13, 10, 14, 12, 11);
+    __m128i tk0 = LoadCells(key);
+    __m128i tk1, tk2, tk3;
+    uint8_t i;
+
+    for (i = 0; i < 32; i += 4)
+    {
+        tk1 = _mm_shuffle_epi8(tk0, pt);
+        tk2 = _mm_shuffle_epi8(tk0, pt2);
+        tk3 = _mm_shuffle_epi8(tk1, pt2);
+        _mm_storeu_si128((__m128i *)(roundKeys + 4 * i),
+                         _mm_packus_epi16(PackCells(tk0, tk1, RC[i], RC[i + 1]),
+                                          PackCells(tk2, tk3, RC[i + 2], RC[i + 3])));
+        tk0 = _mm_shuffle_epi8(tk2, pt2);
+    }
+}
+
+#else
+static void PermuteTweakey(uint8_t *tk)
+{
+    static const uint8_t PT[16] = {9, 15, 8, 13, 10, 14, 12, 11, 0, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t tmp[16];
+    uint8_t j;
+
+    for (j = 0; j < 16; j++)
+    {
+        tmp[j] = tk[PT[j]];
+    }
+    for (j = 0; j < 16; j++)
+    {
+        tk[j] = tmp[j];
+    }
+}
+
+void RunEncryptionKeySchedule(uint8_t *key, uint8_t *roundKeys)
+{
+    /*
+     * Same layout as the assembly versions: the first two rows of
+     * TK1 (two cells per byte) with c0 and c1 added, 4 bytes per round.
+     */
+    uint8_t tk1[16];
+    uint8_t i, j;
+
+    for (j = 0; j < 8; j++)
+    {
+        tk1[2 * j] = key[j] >> 4;
+        tk1[2 * j + 1] = key[j] & 0x0f;
+    }
+    for (i = 0; i < 32; i++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            roundKeys[4 * i + j] = (tk1[2 * j] << 4) | tk1[2 * j + 1];
+        }
+        roundKeys[4 * i + 0] ^= (RC[i] & 0x0f) << 4;
+        roundKeys[4 * i + 2] ^= RC[i] & 0x30;
+        PermuteTweakey(tk1);
+    }
+}
+
+#endif
+#endif